@@ -113,5 +113,22 @@ inline auto make_world_matrix(const float3& scale, const float3& rotation, const
   return translation_matrix * rotation_matrix_y * rotation_matrix_x * rotation_matrix_z * scale_matrix;
 }
 
+/**
+ * Makes the inverse of make_world_matrix, which takes world space positions back into object space
+ *
+ * Every component of scale must be non zero
+ */
+inline auto make_inverse_world_matrix(const float3& scale, const float3& rotation, const float3& position) -> Mat4 {
+  const auto scale_matrix = make_scale(float3{1.0f / scale.x, 1.0f / scale.y, 1.0f / scale.z});
+
+  const auto translation_matrix = make_translate(-position);
+
+  const auto rotation_matrix_x = make_rotate_x(-rotation.x);
+  const auto rotation_matrix_y = make_rotate_y(-rotation.y);
+  const auto rotation_matrix_z = make_rotate_z(-rotation.z);
+
+  return scale_matrix * rotation_matrix_z * rotation_matrix_x * rotation_matrix_y * translation_matrix;
+}
+
 } // namespace bonfire::math
 
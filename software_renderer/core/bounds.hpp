@@ -0,0 +1,57 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+#include <math/matrix4.hpp>
+#include <math/vector3.hpp>
+#include <math/vector4.hpp>
+
+#include "vertex_buffer.hpp"
+
+namespace swr {
+
+struct BoundingSphere {
+  bonfire::math::float3 center{0.0f};
+  float radius = 0.0f;
+};
+
+/**
+ * @brief Sphere around every vertex of a mesh, centered on their bounding box. Not the smallest one, but found in
+ * two passes over the position streams and close to it for the usual meshes.
+ */
+[[nodiscard]] inline auto bounding_sphere(const VertexBuffer& vertices) -> BoundingSphere {
+  if (vertices.empty()) {
+    return {};
+  }
+
+  const auto xs = vertices.x();
+  const auto ys = vertices.y();
+  const auto zs = vertices.z();
+
+  const auto [min_x, max_x] = std::ranges::minmax(xs);
+  const auto [min_y, max_y] = std::ranges::minmax(ys);
+  const auto [min_z, max_z] = std::ranges::minmax(zs);
+  const bonfire::math::float3 center{(min_x + max_x) * 0.5f, (min_y + max_y) * 0.5f, (min_z + max_z) * 0.5f};
+
+  float radius_squared = 0.0f;
+  for (std::size_t i = 0; i < vertices.size(); i++) {
+    const auto dx = xs[i] - center.x;
+    const auto dy = ys[i] - center.y;
+    const auto dz = zs[i] - center.z;
+    radius_squared = std::max(radius_squared, dx * dx + dy * dy + dz * dz);
+  }
+
+  return BoundingSphere{center, std::sqrt(radius_squared)};
+}
+
+// Sphere of an object under its world matrix, scale is the one the matrix was made with
+[[nodiscard]] inline auto transform_bounds(const BoundingSphere& sphere, const bonfire::math::Mat4& world_matrix,
+                                           const bonfire::math::float3& scale) noexcept -> BoundingSphere {
+  // a non uniform scale stretches the sphere, the largest factor keeps all of it inside
+  const auto max_scale = std::max({std::abs(scale.x), std::abs(scale.y), std::abs(scale.z)});
+  return BoundingSphere{(world_matrix * bonfire::math::float4(sphere.center, 1.0f)).to_vec3(), sphere.radius * max_scale};
+}
+
+}  // namespace swr
@@ -1,43 +1,163 @@
 #pragma once
 
+#include <algorithm>
+#include <cmath>
+#include <concepts>
 #include <cstdint>
-#include <future>
 #include <math/vector2.hpp>
 #include <math/vector3.hpp>
 #include <vector>
 
+#include "pipeline.hpp"
 #include "pods.hpp"
+#include "simd.hpp"
+#include "texture.hpp"
 
 namespace swr {
 
 using ColorBuffer = std::vector<std::uint32_t>;
 using ZBuffer = std::vector<float>;
+using IdBuffer = std::vector<std::uint32_t>;
 
 class Canvas {
  public:
-  explicit Canvas(const int width, const int height) : width_(width), height_(height), color_buffer_(width * height), z_buffer_(width * height) {}
+  // granularity of the lazy clear, the tile renderer bins triangles into tiles of the same size
+  static constexpr int TILE_SIZE = 64;
 
+  // id buffer value of pixels no primitive was recorded for
+  static constexpr std::uint32_t NO_ID = 0xFFFFFFFF;
+
+  /*
+   * Masks of the line, triangle outline and rectangle functions, mask(offset) tells whether the pixel at offset
+   * (width * y + x) may be written
+   */
+
+  struct Unmasked {
+    [[nodiscard]] constexpr auto operator()(std::ptrdiff_t) const noexcept -> bool { return true; }
+  };
+
+  // Passes pixels where nothing or a primitive with an id up to last_id was recorded, see id_mask
+  struct IdMask {
+    const std::uint32_t* ids;
+    std::uint32_t last_id;
+
+    [[nodiscard]] auto operator()(const std::ptrdiff_t offset) const noexcept -> bool {
+      const auto id = ids[offset];
+      return id == NO_ID || id <= last_id;
+    }
+  };
+
+  // Passes pixels where the plane is not behind the depth buffer, with the tolerance of DepthEqual, see depth_mask
+  struct DepthMask {
+    const float* depths;
+    int width;
+    AttributePlane plane;
+
+    [[nodiscard]] auto operator()(const std::ptrdiff_t offset) const noexcept -> bool {
+      const auto x = static_cast<int>(offset % width);
+      const auto y = static_cast<int>(offset / width);
+      return plane.at(plane.row(y), x) <= depths[offset] + DepthEqual::TOLERANCE;
+    }
+  };
+
+  explicit Canvas(const int width, const int height)
+      : width_(width),
+        height_(height),
+        tiles_x_((width + TILE_SIZE - 1) / TILE_SIZE),
+        tiles_y_((height + TILE_SIZE - 1) / TILE_SIZE),
+        scissor_{0, 0, width, height},
+        color_buffer_(width * height),
+        front_buffer_(width * height),
+        z_buffer_(width * height, 1.0f),
+        id_buffer_(width * height, NO_ID),
+        tile_clear_generation_(tiles_x_ * tiles_y_, 0),
+        front_tile_clear_generation_(tiles_x_ * tiles_y_, 0) {}
+
+  // buffer that is being drawn to
   [[nodiscard]] auto get_color_buffer() const -> const ColorBuffer& { return color_buffer_; }
 
+  // last finished frame, see swap_buffers
+  [[nodiscard]] auto get_front_buffer() const -> const ColorBuffer& { return front_buffer_; }
+
+  /**
+   * @brief Makes the frame drawn so far the front buffer and continues drawing into the previous front buffer.
+   * Only the buffers are exchanged, the new back buffer still holds an old frame until it is cleared.
+   */
+  void swap_buffers() noexcept {
+    std::swap(color_buffer_, front_buffer_);
+    std::swap(tile_clear_generation_, front_tile_clear_generation_);
+  }
+
   [[nodiscard]] auto get_width() const noexcept -> int { return width_; }
 
   [[nodiscard]] auto get_height() const noexcept -> int { return height_; }
 
+  [[nodiscard]] auto bounds() const noexcept -> Rect { return Rect{0, 0, width_, height_}; }
+
+  /**
+   * @brief Restricts drawing to rect, clipped to the canvas. Every primitive clips against the scissor once, the
+   * overloads taking a clip rect clip against its intersection with the scissor. Those overloads are how concurrent
+   * workers get a scissor of their own, the canvas wide one must not change while drawing is in progress.
+   */
+  void set_scissor(const Rect& rect) noexcept { scissor_ = intersect(rect, bounds()); }
+
+  void reset_scissor() noexcept { scissor_ = bounds(); }
+
+  [[nodiscard]] auto scissor() const noexcept -> const Rect& { return scissor_; }
+
   void clear_color(const std::uint32_t color) {
-    for (std::size_t y = 0; y < height_; y++) {
-      for (std::size_t x = 0; x < width_; x++) {
-        color_buffer_[(width_ * y) + x] = color;
-        z_buffer_[(width_ * y) + x] = 1.0f;
+    simd::stream_fill(color_buffer_.data(), color_buffer_.size(), color);
+
+    // a full clear satisfies any pending lazy clear
+    std::ranges::fill(tile_clear_generation_, clear_generation_);
+  }
+
+  /**
+   * @brief Requests a clear without touching the buffers.
+   *
+   * Every tile remembers the generation it was last cleared for. A tile is cleared the first time it is touched
+   * through prepare_tile, tiles nothing was drawn to are cleared by resolve_clears before the frame is presented.
+   */
+  void clear_color_lazy(const std::uint32_t color) {
+    clear_value_ = color;
+    clear_generation_++;
+  }
+
+  /**
+   * @brief Clears the tile containing the given tile aligned rect if a lazy clear is pending for it.
+   * Different tiles can be prepared from different threads.
+   */
+  void prepare_tile(const Rect& tile) {
+    const auto tile_index = static_cast<std::size_t>((tile.min_y / TILE_SIZE) * tiles_x_ + (tile.min_x / TILE_SIZE));
+
+    if (tile_clear_generation_[tile_index] != clear_generation_) {
+      clear_tile(tile_index);
+    }
+  }
+
+  // Clears every tile that was not prepared since the last lazy clear
+  void resolve_clears() {
+    for (std::size_t tile_index = 0; tile_index < tile_clear_generation_.size(); tile_index++) {
+      if (tile_clear_generation_[tile_index] != clear_generation_) {
+        clear_tile(tile_index);
       }
     }
   }
 
-  void draw_grid(const std::uint32_t grid_size) {
-    for (std::size_t y = 0; y < height_; y++) {
-      for (std::size_t x = 0; x < width_; x++) {
-        if (x % grid_size == 0 || y % grid_size == 0) {
-          color_buffer_[(width_ * y) + x] = 0xFF333333;
-        }
+  void draw_grid(const int grid_size) { draw_grid(grid_size, scissor_); }
+
+  void draw_grid(const int grid_size, const Rect& clip) {
+    const auto area = intersect(clip, scissor_);
+
+    for (int y = area.min_y; y < area.max_y; y++) {
+      if (y % grid_size == 0) {
+        fill_row(y, area.min_x, area.max_x, 0xFF333333);
+        continue;
+      }
+
+      // first grid column inside the area, then every grid_size pixels
+      for (int x = area.min_x + (grid_size - area.min_x % grid_size) % grid_size; x < area.max_x; x += grid_size) {
+        color_buffer_[static_cast<std::size_t>(width_) * y + x] = 0xFF333333;
       }
     }
   }
@@ -48,34 +168,162 @@ class Canvas {
                    color);
   }
 
+  template <typename T, typename V>
+  constexpr void draw_rectangle(const T posx, const T posy, const V width, const V height, const std::uint32_t color,
+                                const Rect& clip) {
+    draw_rectangle(static_cast<int>(posx), static_cast<int>(posy), static_cast<int>(width), static_cast<int>(height),
+                   color, clip);
+  }
+
+  template <typename T, typename V, typename Mask>
+  constexpr void draw_rectangle(const T posx, const T posy, const V width, const V height, const std::uint32_t color,
+                                const Rect& clip, const Mask& mask) {
+    draw_rectangle(static_cast<int>(posx), static_cast<int>(posy), static_cast<int>(width), static_cast<int>(height),
+                   color, clip, mask);
+  }
+
   void draw_rectangle(const int posx, const int posy, const int width, const int height, const std::uint32_t color) {
-    for (std::size_t y = posy; y < posy + height; y++) {
-      for (std::size_t x = posx; x < posx + width; x++) {
-        color_buffer_[(width_ * y) + x] = color;
-      }
+    draw_rectangle(posx, posy, width, height, color, scissor_);
+  }
+
+  void draw_rectangle(const int posx, const int posy, const int width, const int height, const std::uint32_t color,
+                      const Rect& clip) {
+    draw_rectangle(posx, posy, width, height, color, clip, Unmasked{});
+  }
+
+  template <typename Mask>
+  void draw_rectangle(const int posx, const int posy, const int width, const int height, const std::uint32_t color,
+                      const Rect& clip, const Mask& mask) {
+    const auto area = intersect(intersect(Rect{posx, posy, posx + width, posy + height}, clip), scissor_);
+    if (area.empty()) {
+      return;
+    }
+
+    for (int y = area.min_y; y < area.max_y; y++) {
+      fill_row(y, area.min_x, area.max_x, color, mask);
     }
   }
 
-  void draw_pixel(const int posx, const int posy, const std::uint32_t color) { color_buffer_[width_ * posy + posx] = color; }
+  /**
+   * @brief Fills pixels [x0, x1) of row y. The span is clipped once, the fill itself is a plain std::fill_n which
+   * compilers turn into wide stores.
+   */
+  void fill_span(const int y, const int x0, const int x1, const std::uint32_t color) {
+    fill_span(y, x0, x1, color, scissor_);
+  }
+
+  void fill_span(const int y, const int x0, const int x1, const std::uint32_t color, const Rect& clip) {
+    const auto area = intersect(clip, scissor_);
+    if (y < area.min_y || y >= area.max_y) {
+      return;
+    }
+
+    const auto start = std::max(x0, area.min_x);
+    const auto end = std::min(x1, area.max_x);
+    if (start < end) {
+      fill_row(y, start, end, color);
+    }
+  }
+
+  /**
+   * @brief Depth tested fill of pixels [x0, x1) of row y. Depth goes linearly from z0 at x0 with dz per pixel,
+   * pixels closer than what the depth buffer holds are written to both buffers. Returns how many were written.
+   */
+  auto fill_span_depth(const int y, const int x0, const int x1, const float z0, const float dz, const std::uint32_t color)
+      -> std::size_t {
+    return fill_span_depth(y, x0, x1, z0, dz, color, scissor_);
+  }
+
+  auto fill_span_depth(const int y, const int x0, const int x1, const float z0, const float dz, const std::uint32_t color,
+                       const Rect& clip) -> std::size_t {
+    const auto area = intersect(clip, scissor_);
+    if (y < area.min_y || y >= area.max_y) {
+      return 0;
+    }
+
+    const auto start = std::max(x0, area.min_x);
+    const auto end = std::min(x1, area.max_x);
+    if (start >= end) {
+      return 0;
+    }
+
+    const auto offset = static_cast<std::size_t>(width_) * static_cast<std::size_t>(y) + static_cast<std::size_t>(start);
+    return simd::fill_depth_tested(color_buffer_.data() + offset, z_buffer_.data() + offset, end - start, start - x0, z0, dz, color);
+  }
+
+  // Depth only fill_span_depth, the color buffer is not touched
+  void write_span_depth(const int y, const int x0, const int x1, const float z0, const float dz, const Rect& clip) {
+    const auto area = intersect(clip, scissor_);
+    if (y < area.min_y || y >= area.max_y) {
+      return;
+    }
+
+    const auto start = std::max(x0, area.min_x);
+    const auto end = std::min(x1, area.max_x);
+    if (start < end) {
+      const auto offset = static_cast<std::size_t>(width_) * static_cast<std::size_t>(y) + static_cast<std::size_t>(start);
+      simd::write_depth_tested(z_buffer_.data() + offset, end - start, start - x0, z0, dz);
+    }
+  }
+
+  void draw_pixel(const int posx, const int posy, const std::uint32_t color) { draw_pixel(posx, posy, color, scissor_); }
+
+  void draw_pixel(const int posx, const int posy, const std::uint32_t color, const Rect& clip) {
+    if (clip.contains(posx, posy) && scissor_.contains(posx, posy)) {
+      color_buffer_[static_cast<std::size_t>(width_) * posy + posx] = color;
+    }
+  }
 
   void draw_line(const int x0, const int y0, const int x1, const int y1, const std::uint32_t color) {
-    // DDA line drawing algo
-    const auto delta_x = x1 - x0;
-    const auto delta_y = y1 - y0;
+    draw_line(x0, y0, x1, y1, color, scissor_);
+  }
 
-    const auto side_len = std::abs(delta_x) >= std::abs(delta_y) ? std::abs(delta_x) : std::abs(delta_y);
+  void draw_line(const int x0, const int y0, const int x1, const int y1, const std::uint32_t color, const Rect& clip) {
+    draw_line(x0, y0, x1, y1, color, clip, Unmasked{});
+  }
 
-    // find how much we should increment in both x and y each step
-    const float x_inc = static_cast<float>(delta_x) / static_cast<float>(side_len);
-    const float y_inc = static_cast<float>(delta_y) / static_cast<float>(side_len);
+  template <typename Mask>
+  void draw_line(const int x0, const int y0, const int x1, const int y1, const std::uint32_t color, const Rect& clip,
+                 const Mask& mask) {
+    const auto area = intersect(clip, scissor_);
+    if (area.empty()) {
+      return;
+    }
 
-    auto current_x = static_cast<float>(x0);
-    auto current_y = static_cast<float>(y0);
+    // Cohen-Sutherland outcodes, both ends on the same outer side means nothing to draw
+    const auto code0 = outcode(x0, y0, area);
+    const auto code1 = outcode(x1, y1, area);
+    if ((code0 & code1) != 0) {
+      return;
+    }
 
-    for (int i = 0; i <= side_len; i++) {
-      draw_pixel(static_cast<int>(std::round(current_x)), static_cast<int>(std::round(current_y)), color);
-      current_x += x_inc;
-      current_y += y_inc;
+    if (y0 == y1) {
+      if (y0 >= area.min_y && y0 < area.max_y) {
+        const auto start = std::max(std::min(x0, x1), area.min_x);
+        const auto end = std::min(std::max(x0, x1) + 1, area.max_x);
+        if (start < end) {
+          fill_row(y0, start, end, color, mask);
+        }
+      }
+      return;
+    }
+
+    if (x0 == x1) {
+      draw_vertical_line(x0, std::min(y0, y1), std::max(y0, y1), color, area, mask);
+      return;
+    }
+
+    const auto delta_x = std::abs(x1 - x0);
+    const auto delta_y = std::abs(y1 - y0);
+    const auto step_x = x1 > x0 ? 1 : -1;
+    const auto step_y = y1 > y0 ? 1 : -1;
+
+    if (delta_x >= delta_y) {
+      draw_line_steps<true>(x0, y0, delta_x, delta_y, step_x, step_y, Axis{area.min_x, area.max_x - 1, step_x},
+                      Axis{area.min_y, area.max_y - 1, step_y * width_}, color, (code0 | code1) == 0, mask);
+    } else {
+      draw_line_steps<false>(y0, x0, delta_y, delta_x, step_y, step_x, Axis{area.min_y, area.max_y - 1, step_y * width_},
+                      Axis{area.min_x, area.max_x - 1, step_x}, color, (code0 | code1) == 0, mask);
     }
   }
 
@@ -85,224 +333,422 @@ class Canvas {
                   static_cast<int>(x2), static_cast<int>(y2), color);
   }
 
+  template <typename T>
+  constexpr void draw_triangle(T x0, T y0, T x1, T y1, T x2, T y2, const std::uint32_t color, const Rect& clip) {
+    draw_triangle(static_cast<int>(x0), static_cast<int>(y0), static_cast<int>(x1), static_cast<int>(y1),
+                  static_cast<int>(x2), static_cast<int>(y2), color, clip);
+  }
+
+  template <typename T, typename Mask>
+  constexpr void draw_triangle(T x0, T y0, T x1, T y1, T x2, T y2, const std::uint32_t color, const Rect& clip,
+                               const Mask& mask) {
+    draw_triangle(static_cast<int>(x0), static_cast<int>(y0), static_cast<int>(x1), static_cast<int>(y1),
+                  static_cast<int>(x2), static_cast<int>(y2), color, clip, mask);
+  }
+
   void draw_triangle(const int x0, const int y0, const int x1, const int y1, const int x2,
                      const int y2, const std::uint32_t color) {
-    draw_line(x0, y0, x1, y1, color);
-    draw_line(x1, y1, x2, y2, color);
-    draw_line(x2, y2, x0, y0, color);
+    draw_triangle(x0, y0, x1, y1, x2, y2, color, scissor_);
+  }
+
+  void draw_triangle(const int x0, const int y0, const int x1, const int y1, const int x2,
+                     const int y2, const std::uint32_t color, const Rect& clip) {
+    draw_triangle(x0, y0, x1, y1, x2, y2, color, clip, Unmasked{});
+  }
+
+  template <typename Mask>
+  void draw_triangle(const int x0, const int y0, const int x1, const int y1, const int x2,
+                     const int y2, const std::uint32_t color, const Rect& clip, const Mask& mask) {
+    draw_line(x0, y0, x1, y1, color, clip, mask);
+    draw_line(x1, y1, x2, y2, color, clip, mask);
+    draw_line(x2, y2, x0, y0, color, clip, mask);
   }
 
   template <typename T>
-  constexpr void draw_filled_triangle(T x0, T y0, T x1, T y1, T x2, T y2, const std::uint32_t color) {
-    draw_filled_triangle(static_cast<int>(x0), static_cast<int>(y0), static_cast<int>(x1), static_cast<int>(y1),
-                         static_cast<int>(x2), static_cast<int>(y2), color);
+  constexpr auto draw_filled_triangle(T x0, T y0, T x1, T y1, T x2, T y2, const std::uint32_t color) -> std::size_t {
+    return draw_filled_triangle(x0, y0, x1, y1, x2, y2, color, scissor_);
   }
 
-  void draw_filled_triangle(int x0, int y0, int x1, int y1, int x2, int y2,
-                            const std::uint32_t color) {
-    // apply flat bottom, flat top technique
-    // sort the vertices by y component ascending y0 < y1 < y2
-    if (y0 > y1) {
-      std::swap(y0, y1);
-      std::swap(x0, x1);
-    }
-    if (y1 > y2) {
-      std::swap(y1, y2);
-      std::swap(x1, x2);
-    }
-    if (y0 > y1) {
-      std::swap(y0, y1);
-      std::swap(x0, x1);
-    }
+  // Positions are in pixels, fractional positions keep their sub-pixel part
+  template <typename T>
+  constexpr auto draw_filled_triangle(T x0, T y0, T x1, T y1, T x2, T y2, const std::uint32_t color, const Rect& clip)
+      -> std::size_t {
+    return draw_filled_triangle(Vertex2{static_cast<float>(x0), static_cast<float>(y0)},
+                                Vertex2{static_cast<float>(x1), static_cast<float>(y1)},
+                                Vertex2{static_cast<float>(x2), static_cast<float>(y2)}, color, clip);
+  }
 
-    // prevent divide by zero
-    if (y1 == y2) {
-      // if we dont have a bottom part of the triangle, draw from bottom to top
-      draw_flat_bottom_triangle(x0, y0, x1, y1, x2, y2, color);
-      return;
-    }
+  /*
+   * Triangle rasterizers take 28.4 fixed point vertices, sample pixels at their centers and follow the top-left
+   * fill rule (see for_each_triangle_span). They return the number of pixels they wrote.
+   */
 
-    // prevent divide by zero
-    if (y0 == y1) {
-      // if we dont have the top part of the triangle, draw from top to bottom
-      draw_flat_top_triangle(x0, y0, x1, y1, x2, y2, color);
-      return;
-    }
+  auto draw_filled_triangle(const Vertex2& v0, const Vertex2& v1, const Vertex2& v2, const std::uint32_t color,
+                            const Rect& clip) -> std::size_t {
+    return rasterize_triangle(v0, v1, v2, PixelPipeline<FlatShader>{FlatShader{color}}, clip);
+  }
 
-    // find triangle mid point
-    const auto mx = (((x2 - x0) * (y1 - y0)) / (y2 - y0)) + x0;
-    const auto my = y1;
+  auto draw_textured_triangle(const Vertex2& v0, const Vertex2& v1, const Vertex2& v2, const Texture& texture,
+                              const SamplerState& sampler = {}) -> std::size_t {
+    return draw_textured_triangle(v0, v1, v2, texture, sampler, scissor_);
+  }
 
-    // draw
-    draw_flat_bottom_triangle(x0, y0, x1, y1, mx, my, color);
-    draw_flat_top_triangle(x1, y1, mx, my, x2, y2, color);
+  auto draw_textured_triangle(const Vertex2& v0, const Vertex2& v1, const Vertex2& v2, const Texture& texture,
+                              const SamplerState& sampler, const Rect& clip) -> std::size_t {
+    std::size_t written = 0;
+    with_texture_shader(v0, v1, v2, texture, sampler, [&](const auto& shader) {
+      written = rasterize_triangle(v0, v1, v2, PixelPipeline<std::remove_cvref_t<decltype(shader)>>{shader}, clip);
+    });
+    return written;
   }
 
-  // triangle midpoint, my = y1,  mx - x0 / x2 - x0 = y1 - y0 / y2 - y0
-  // mx =  (((x2 - x0) * (y1 - y0)) / (y2 - y0)) + x0;  => triangle similarity
+  // Writes the pixels of a triangle through pipeline, see pipeline.hpp
+  template <SpanPipeline Pipeline>
+  auto rasterize_triangle(const Vertex2& v0, const Vertex2& v1, const Vertex2& v2, const Pipeline& pipeline,
+                          const Rect& clip) -> std::size_t {
+    std::size_t written = 0;
+    for_each_triangle_span(v0, v1, v2, clip, [&](const int y, const int x0, const int x1) {
+      written += rasterize_span(y, x0, x1, pipeline);
+    });
+    return written;
+  }
 
-  void draw_textured_triangle(Vertex2 v0, Vertex2 v1, Vertex2 v2, const Texture& texture) {
-    // We need to sort the vertices by y-coordinate ascending (y0 < y1 < y2)
-    if (v0.y > v1.y) {
-      std::swap(v0, v1);
-    }
-    if (v1.y > v2.y) {
-      std::swap(v1, v2);
-    }
-    if (v0.y > v1.y) {
-      std::swap(v0, v1);
-    }
+  // Writes pixels [x0, x1) of row y through pipeline, the span must be inside the canvas
+  template <SpanPipeline Pipeline>
+  auto rasterize_span(const int y, const int x0, const int x1, const Pipeline& pipeline) -> std::size_t {
+    const auto row = static_cast<std::ptrdiff_t>(width_) * y;
+    return pipeline.shade_span(SpanTarget{color_buffer_.data() + row, id_buffer_.data() + row, z_buffer_.data() + row, y}, x0, x1);
+  }
 
-    // Render the upper part of the triangle (flat-bottom)
+  /*
+   * Depth buffer
+   *
+   * Depths are 0 at the near and 1 at the far plane and interpolated linearly over the screen from per vertex
+   * depths given as an AttributePlane. Only a depth prepass draws through it, so it is cleared per tile by the pass
+   * itself rather than along with the color buffer.
+   */
 
-    float inv_slope_1 = 0;
-    float inv_slope_2 = 0;
+  [[nodiscard]] auto get_z_buffer() const -> const ZBuffer& { return z_buffer_; }
 
-    if (v1.y - v0.y != 0) {
-      inv_slope_1 = static_cast<float>((v1.x - v0.x)) / static_cast<float>(abs(v1.y - v0.y));
-    }
-    if (v2.y - v0.y != 0) {
-      inv_slope_2 = static_cast<float>((v2.x - v0.x)) / static_cast<float>(abs(v2.y - v0.y));
+  void clear_depth(const Rect& rect) {
+    const auto area = intersect(rect, bounds());
+    for (int y = area.min_y; y < area.max_y; y++) {
+      std::fill_n(z_buffer_.begin() + (static_cast<std::ptrdiff_t>(width_) * y + area.min_x), area.max_x - area.min_x, 1.0f);
     }
+  }
 
-    if (v1.y - v0.y != 0) {
-      for (int y = v0.y; y <= v1.y; y++) {
-        int x_start = static_cast<int>(static_cast<float>(v1.x) + static_cast<float>((y - v1.y)) * inv_slope_1);
-        int x_end = static_cast<int>(static_cast<float>(v0.x) + static_cast<float>((y - v0.y)) * inv_slope_2);
+  // Depth tested draw_filled_triangle, see fill_span_depth
+  auto draw_filled_triangle_depth(const Vertex2& v0, const Vertex2& v1, const Vertex2& v2, const AttributePlane& depth,
+                                  const std::uint32_t color, const Rect& clip) -> std::size_t {
+    std::size_t written = 0;
+    for_each_triangle_span(v0, v1, v2, clip, [&](const int y, const int x0, const int x1) {
+      written += fill_span_depth(y, x0, x1, depth.at(depth.row(y), x0), depth.dx, color, clip);
+    });
+    return written;
+  }
 
-        if (x_end < x_start) {
-          std::swap(x_start, x_end);  // swap if x_start is to the right of x_end
-        }
+  // Writes the depth of a triangle where it is closer than the depth buffer and nothing else, see write_span_depth
+  void draw_triangle_depth(const Vertex2& v0, const Vertex2& v1, const Vertex2& v2, const AttributePlane& depth,
+                           const Rect& clip) {
+    for_each_triangle_span(v0, v1, v2, clip, [&](const int y, const int x0, const int x1) {
+      write_span_depth(y, x0, x1, depth.at(depth.row(y), x0), depth.dx, clip);
+    });
+  }
 
-        for (int x = x_start; x < x_end; x++) {
-          // Draw our pixel with the color that comes from the texture
-          Vertex2 vp{};
-          vp.x = x;
-          vp.y = y;
+  // Mask letting through the pixels where the plane of a surface is not behind the depth buffer
+  [[nodiscard]] auto depth_mask(const AttributePlane& depth) const noexcept -> DepthMask {
+    return DepthMask{z_buffer_.data(), width_, depth};
+  }
 
-          draw_texel(v0, v1, v2, vp, texture);
-        }
-      }
-    }
+  /*
+   * Visibility buffer
+   *
+   * Instead of shading every primitive as it is rasterized, the id of the primitive covering a pixel is recorded
+   * first and every pixel is shaded once afterwards. Ids are opaque to the canvas, later writes replace earlier
+   * ones exactly like colors do, so resolving gives the same image as drawing directly.
+   */
 
-    // Render the bottom part of the triangle (flat-top)
-    inv_slope_1 = 0;
-    inv_slope_2 = 0;
+  [[nodiscard]] auto get_id_buffer() const -> const IdBuffer& { return id_buffer_; }
 
-    if (v2.y - v1.y != 0) {
-      inv_slope_1 = static_cast<float>((v2.x - v1.x)) / static_cast<float>(abs(v2.y - v1.y));
-    }
-    if (v2.y - v0.y != 0) {
-      inv_slope_2 = static_cast<float>((v2.x - v0.x)) / static_cast<float>(abs(v2.y - v0.y));
+  // Mask letting through the pixels no primitive recorded after last_id covers, ids have to grow in drawing order
+  [[nodiscard]] auto id_mask(const std::uint32_t last_id) const noexcept -> IdMask {
+    return IdMask{id_buffer_.data(), last_id};
+  }
+
+  void clear_ids(const Rect& rect) {
+    const auto area = intersect(rect, bounds());
+    for (int y = area.min_y; y < area.max_y; y++) {
+      std::fill_n(id_buffer_.begin() + (static_cast<std::ptrdiff_t>(width_) * y + area.min_x), area.max_x - area.min_x, NO_ID);
     }
+  }
 
-    if (v2.y - v1.y != 0) {
-      for (int y = v1.y; y <= v2.y; y++) {
-        int x_start = static_cast<int>(static_cast<float>(v1.x) + static_cast<float>((y - v1.y)) * inv_slope_1);
-        int x_end = static_cast<int>(static_cast<float>(v0.x) + static_cast<float>((y - v0.y)) * inv_slope_2);
+  // Records id for the pixels draw_filled_triangle and draw_textured_triangle cover
+  void draw_triangle_id(const Vertex2& v0, const Vertex2& v1, const Vertex2& v2, const std::uint32_t id, const Rect& clip) {
+    for_each_triangle_span(v0, v1, v2, clip, [&](const int y, const int x0, const int x1) { fill_ids(y, x0, x1, id); });
+  }
 
-        if (x_end < x_start) {
-          std::swap(x_start, x_end);  // swap if x_start is to the right of x_end
+  /**
+   * @brief Walks the id buffer inside area and calls shade(id, y, x0, x1) for every run of pixels [x0, x1) of row y
+   * sharing the same id. Pixels without an id are left untouched.
+   */
+  template <typename ShadeFn>
+  void resolve_ids(const Rect& rect, ShadeFn&& shade) {
+    const auto area = intersect(rect, bounds());
+    for (int y = area.min_y; y < area.max_y; y++) {
+      const auto* row = id_buffer_.data() + static_cast<std::ptrdiff_t>(width_) * y;
+
+      for (int x = area.min_x; x < area.max_x;) {
+        const auto id = row[x];
+        const auto run_start = x;
+        while (x < area.max_x && row[x] == id) {
+          x++;
         }
 
-        for (int x = x_start; x < x_end; x++) {
-          // Draw our pixel with the color that comes from the texture
-          Vertex2 vp{};
-          vp.x = x;
-          vp.y = y;
-
-          draw_texel(v0, v1, v2, vp, texture);
+        if (id != NO_ID) {
+          shade(id, y, run_start, x);
         }
       }
     }
   }
 
  private:
-  void draw_flat_bottom_triangle(const int x0, const int y0, const int x1, const int y1, const int mx,
-                                 const int my, const std::uint32_t color) {
-    // find the 2 inverted slopes
-    const float inv_slope0 = static_cast<float>((x1 - x0)) / static_cast<float>((y1 - y0));
-    const float inv_slope1 = static_cast<float>((mx - x0)) / static_cast<float>((my - y0));
-
-    // start the x_start and x_end from the top vertex
-    auto x_start = static_cast<float>(x0);
-    auto x_end = static_cast<float>(x0);
+  /**
+   * Calls span(y, x0, x1) with the clipped, non-empty pixel spans of a triangle.
+   *
+   * A pixel is covered when its center is inside all three edges. Centers exactly on an edge follow the top-left
+   * rule: they belong to the triangle only if the edge is a left edge or a horizontal top edge, so triangles sharing
+   * an edge neither both write the pixels along it nor leave a gap. The span of every row is solved from the edge
+   * functions in integer math, a triangle cut by tile or canvas edges covers exactly the pixels it covers whole.
+   */
+  template <typename SpanFn>
+  void for_each_triangle_span(const Vertex2& v0, const Vertex2& v1, const Vertex2& v2, const Rect& clip, SpanFn&& span) {
+    constexpr std::int64_t HALF = SUBPIXEL_SCALE / 2;
+    const auto visible = intersect(clip, scissor_);
+
+    // twice the signed area, orient the edges so the inside is positive for both windings
+    const auto area = std::int64_t{v1.x - v0.x} * (v2.y - v0.y) - std::int64_t{v1.y - v0.y} * (v2.x - v0.x);
+    if (area == 0) {
+      return;
+    }
 
-    for (int y = y0; y <= my; y++) {
-      draw_line(static_cast<int>(x_start), y, static_cast<int>(x_end), y, color);
+    const auto& p1 = area > 0 ? v1 : v2;
+    const auto& p2 = area > 0 ? v2 : v1;
+    const Edge edges[3] = {make_edge(p1, p2), make_edge(p2, v0), make_edge(v0, p1)};
+
+    const auto min_x = std::min({v0.x, v1.x, v2.x});
+    const auto max_x = std::max({v0.x, v1.x, v2.x});
+    const auto min_y = std::min({v0.y, v1.y, v2.y});
+    const auto max_y = std::max({v0.y, v1.y, v2.y});
+
+    // pixels whose centers are inside the bounding box
+    const auto col_begin = std::max<std::int64_t>(visible.min_x, ceil_div(min_x - HALF, SUBPIXEL_SCALE));
+    const auto col_last = std::min<std::int64_t>(visible.max_x - 1, floor_div(max_x - HALF, SUBPIXEL_SCALE));
+    const auto row_begin = std::max<std::int64_t>(visible.min_y, ceil_div(min_y - HALF, SUBPIXEL_SCALE));
+    const auto row_last = std::min<std::int64_t>(visible.max_y - 1, floor_div(max_y - HALF, SUBPIXEL_SCALE));
+
+    for (auto y = row_begin; y <= row_last; y++) {
+      const auto sample_y = y * SUBPIXEL_SCALE + HALF;
+      auto first = col_begin;
+      auto last = col_last;
+
+      // a * (x * SUBPIXEL_SCALE + HALF) + k >= 0 bounds x from below for a > 0 and from above for a < 0
+      for (const auto& [a, b, c] : edges) {
+        const auto k = b * sample_y + c;
+        if (a > 0) {
+          first = std::max(first, ceil_div(-k - HALF * a, SUBPIXEL_SCALE * a));
+        } else if (a < 0) {
+          last = std::min(last, floor_div(k + HALF * a, -SUBPIXEL_SCALE * a));
+        } else if (k < 0) {
+          last = first - 1;
+        }
+      }
 
-      x_start += inv_slope0;
-      x_end += inv_slope1;
+      if (first <= last) {
+        span(static_cast<int>(y), static_cast<int>(first), static_cast<int>(last + 1));
+      }
     }
   }
 
-  void draw_flat_top_triangle(const int x1, const int y1, const int mx, const int my, const int x2,
-                              const int y2, const std::uint32_t color) {
-    // find the 2 inverted slopes
-    const float inv_slope0 = static_cast<float>((x2 - x1)) / static_cast<float>((y2 - y1));
-    const float inv_slope1 = static_cast<float>((x2 - mx)) / static_cast<float>((y2 - my));
+  // edge function a * x + b * y + c of fixed point sample positions, a sample is inside when it is >= 0
+  struct Edge {
+    std::int64_t a, b, c;
+  };
 
-    // start the x_start and x_end from the bottom vertex
-    auto x_start = static_cast<float>(x2);
-    auto x_end = static_cast<float>(x2);
+  static auto make_edge(const Vertex2& from, const Vertex2& to) noexcept -> Edge {
+    Edge edge{std::int64_t{from.y} - to.y, std::int64_t{to.x} - from.x, 0};
+    edge.c = -edge.a * from.x - edge.b * from.y;
 
-    for (int y = y2; y >= my; y--) {
-      draw_line(static_cast<int>(x_start), y, static_cast<int>(x_end), y, color);
+    // the inside of a left edge is in +x, the inside of a top edge is in +y and it is horizontal,
+    // samples exactly on any other edge are outside
+    const bool top_left = edge.a > 0 || (edge.a == 0 && edge.b > 0);
+    if (!top_left) {
+      edge.c -= 1;
+    }
+    return edge;
+  }
 
-      x_start -= inv_slope0;
-      x_end -= inv_slope1;
+  enum Outcode : unsigned { INSIDE = 0, LEFT = 1, RIGHT = 2, TOP = 4, BOTTOM = 8 };
+
+  static auto outcode(const int x, const int y, const Rect& clip) noexcept -> unsigned {
+    unsigned code = INSIDE;
+    if (x < clip.min_x) {
+      code |= LEFT;
+    } else if (x >= clip.max_x) {
+      code |= RIGHT;
+    }
+    if (y < clip.min_y) {
+      code |= TOP;
+    } else if (y >= clip.max_y) {
+      code |= BOTTOM;
     }
+    return code;
   }
 
-  void draw_texel(const Vertex2& a, const Vertex2& b, const Vertex2& c, const Vertex2& p, const Texture& texture) {
-    const auto weights = barycentric_weights(a, b, c, p);
+  // inclusive clip range of one axis and the color buffer offset of a single step along it
+  struct Axis {
+    int min, max;
+    int stride;
+  };
 
-    const float alpha = weights.x;
-    const float beta = weights.y;
-    const float gamma = weights.z;
+  static auto ceil_div(const std::int64_t a, const std::int64_t b) noexcept -> std::int64_t {
+    return a >= 0 ? (a + b - 1) / b : -((-a) / b);
+  }
+
+  static auto floor_div(const std::int64_t a, const std::int64_t b) noexcept -> std::int64_t {
+    return a >= 0 ? a / b : -((-a + b - 1) / b);
+  }
+
+  /**
+   * Integer (Bresenham) line stepping along the major axis. The minor offset at step k is
+   * floor((2 * k * d_minor + d_major) / (2 * d_major)), so instead of stepping through invisible pixels we solve
+   * for the first and last step inside the clip rect and start right there. Lines cut by tile or canvas edges
+   * therefore land on exactly the same pixels as when they are drawn whole.
+   */
+  template <bool XMajor, typename Mask>
+  void draw_line_steps(const int major0, const int minor0, const int d_major, const int d_minor, const int s_major,
+                       const int s_minor, const Axis& major, const Axis& minor, const std::uint32_t color,
+                       const bool inside, const Mask& mask) {
+    std::int64_t k_begin = 0;
+    std::int64_t k_end = d_major;
+
+    if (!inside) {
+      // steps whose major coordinate is inside the clip rect
+      k_begin = std::max<std::int64_t>(k_begin, s_major > 0 ? major.min - major0 : major0 - major.max);
+      k_end = std::min<std::int64_t>(k_end, s_major > 0 ? major.max - major0 : major0 - major.min);
+
+      // minor offsets inside the clip rect, turned into a step range since the offset grows monotonically
+      const std::int64_t m_lo = std::max(0, s_minor > 0 ? minor.min - minor0 : minor0 - minor.max);
+      const std::int64_t m_hi = std::min(d_minor, s_minor > 0 ? minor.max - minor0 : minor0 - minor.min);
+      if (m_lo > m_hi) {
+        return;
+      }
+
+      k_begin = std::max(k_begin, ceil_div(2 * d_major * m_lo - d_major, 2 * std::int64_t{d_minor}));
+      k_end = std::min(k_end, ceil_div(2 * d_major * (m_hi + 1) - d_major, 2 * std::int64_t{d_minor}) - 1);
+    }
+
+    if (k_begin > k_end) {
+      return;
+    }
 
-    // Perform the interpolation of all U and V values using barycentric weights
-    const float interpolated_u = (a.u) * alpha + (b.u) * beta + (c.u) * gamma;
-    const float interpolated_v = (a.v) * alpha + (b.v) * beta + (c.v) * gamma;
+    const std::int64_t two_major = 2 * std::int64_t{d_major};
+    const std::int64_t two_minor = 2 * std::int64_t{d_minor};
+    const std::int64_t numerator = two_minor * k_begin + d_major;
 
-    // Map the UV coordinate to the full texture width and height
-    const int tex_x = static_cast<int>(abs(interpolated_u * static_cast<float>(texture.width))) % static_cast<int>(texture.width);
-    const int tex_y = static_cast<int>(abs(interpolated_v * static_cast<float>(texture.height))) % static_cast<int>(texture.height);
+    auto error = numerator % two_major;
+    const auto minor_offset = numerator / two_major;
 
-    const auto idx = ((texture.width * tex_y) + tex_x);
+    // position of the first visible step
+    const auto first_major = major0 + s_major * static_cast<int>(k_begin);
+    const auto first_minor = minor0 + s_minor * static_cast<int>(minor_offset);
+    const auto start_x = XMajor ? first_major : first_minor;
+    const auto start_y = XMajor ? first_minor : first_major;
 
-    draw_pixel(p.x, p.y, texture.texels[idx]);
+    auto* pixel = color_buffer_.data() + (static_cast<std::ptrdiff_t>(width_) * start_y + start_x);
+
+    for (auto k = k_begin; k <= k_end; k++) {
+      if (mask(pixel - color_buffer_.data())) {
+        *pixel = color;
+      }
+      pixel += major.stride;
+      error += two_minor;
+      if (error >= two_major) {
+        error -= two_major;
+        pixel += minor.stride;
+      }
+    }
+  }
+
+  void fill_ids(const int y, const int x0, const int x1, const std::uint32_t id) {
+    std::fill_n(id_buffer_.begin() + (static_cast<std::ptrdiff_t>(width_) * y + x0), x1 - x0, id);
+  }
+
+  void fill_row(const int y, const int x0, const int x1, const std::uint32_t color) {
+    std::fill_n(color_buffer_.begin() + (static_cast<std::ptrdiff_t>(width_) * y + x0), x1 - x0, color);
+  }
+
+  template <typename Mask>
+  void fill_row(const int y, const int x0, const int x1, const std::uint32_t color, const Mask& mask) {
+    if constexpr (std::same_as<Mask, Unmasked>) {
+      fill_row(y, x0, x1, color);
+    } else {
+      const auto row = static_cast<std::ptrdiff_t>(width_) * y;
+      for (auto offset = row + x0; offset < row + x1; offset++) {
+        if (mask(offset)) {
+          color_buffer_[static_cast<std::size_t>(offset)] = color;
+        }
+      }
+    }
   }
 
-  static auto barycentric_weights(const Vertex2& a, const Vertex2& b, const Vertex2& c, const Vertex2& p)
-      -> bonfire::math::float3 {
-    // Find the vectors between the vertices ABC and point p
-    const auto ac = c - a;
-    const auto ab = b - a;
-    const auto ap = p - a;
-    const auto pc = c - p;
-    const auto pb = b - p;
+  template <typename Mask>
+  void draw_vertical_line(const int x, const int y0, const int y1, const std::uint32_t color, const Rect& clip,
+                          const Mask& mask) {
+    if (x < clip.min_x || x >= clip.max_x) {
+      return;
+    }
 
-    // Compute the area of the full parallegram/triangle ABC using 2D cross product
-    const auto area_parallelogram_abc = static_cast<float>((ac.x * ab.y - ac.y * ab.x));  // || AC x AB ||
+    const auto end = static_cast<std::ptrdiff_t>(width_) * std::min(y1 + 1, clip.max_y) + x;
+    for (auto offset = static_cast<std::ptrdiff_t>(width_) * std::max(y0, clip.min_y) + x; offset < end; offset += width_) {
+      if (mask(offset)) {
+        color_buffer_[static_cast<std::size_t>(offset)] = color;
+      }
+    }
+  }
 
-    // Alpha is the area of the small parallelogram/triangle PBC divided by the area of the full parallelogram/triangle ABC
-    const float alpha = static_cast<float>((pc.x * pb.y - pc.y * pb.x)) / area_parallelogram_abc;
+  void clear_tile(const std::size_t tile_index) {
+    const auto tx = static_cast<int>(tile_index) % tiles_x_;
+    const auto ty = static_cast<int>(tile_index) / tiles_x_;
 
-    // Beta is the area of the small parallelogram/triangle APC divided by the area of the full parallelogram/triangle ABC
-    const float beta = static_cast<float>((ac.x * ap.y - ac.y * ap.x)) / area_parallelogram_abc;
+    const auto min_x = tx * TILE_SIZE;
+    const auto max_x = std::min(min_x + TILE_SIZE, width_);
+    const auto max_y = std::min((ty + 1) * TILE_SIZE, height_);
 
-    // Weight gamma is easily found since barycentric coordinates always add up to 1.0
-    const float gamma = std::abs(1.0f - alpha - beta);
+    // regular stores on purpose, the tile is about to be drawn to so we want it in the cache
+    for (int y = ty * TILE_SIZE; y < max_y; y++) {
+      const auto row = static_cast<std::size_t>(width_ * y + min_x);
+      std::fill_n(color_buffer_.begin() + row, max_x - min_x, clear_value_);
+    }
 
-    return bonfire::math::float3{std::abs(alpha), std::abs(beta), gamma};
+    tile_clear_generation_[tile_index] = clear_generation_;
   }
 
 private:
   int width_;
   int height_;
+  int tiles_x_;
+  int tiles_y_;
+  Rect scissor_;
   ColorBuffer color_buffer_;
+  ColorBuffer front_buffer_;
   ZBuffer z_buffer_;
+  IdBuffer id_buffer_;
+
+  std::uint32_t clear_value_ = 0;
+  std::uint32_t clear_generation_ = 0;
+  // clear generation per tile of the back and the front buffer, swapped along with them
+  std::vector<std::uint32_t> tile_clear_generation_;
+  std::vector<std::uint32_t> front_tile_clear_generation_;
 };
 
 }  // namespace swr
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include <math/vector2.hpp>
+#include <math/vector4.hpp>
+
+namespace swr {
+
+/*
+ * Clipping
+ *
+ * Triangles are clipped in homogeneous clip space, before the perspective divide, where the view volume is
+ * -w <= x, y, z <= w and a point behind the camera cannot end up on the wrong side of it. Only near and far are the
+ * planes of the view volume. x and y are clipped against a guard band GUARD_BAND times wider than the screen: the
+ * rasterizer scissors whatever lies between the screen and the guard band for free, while clipping there would add
+ * vertices and triangles to most of those that merely overlap a screen edge.
+ */
+
+// How far outside the screen the side planes are, in screen sizes from its center
+inline constexpr float GUARD_BAND = 8.0f;
+
+// Planes a clip space position is outside of, one bit per plane
+enum ClipPlane : std::uint8_t {
+  CLIP_LEFT = 1 << 0,
+  CLIP_RIGHT = 1 << 1,
+  CLIP_BOTTOM = 1 << 2,
+  CLIP_TOP = 1 << 3,
+  CLIP_NEAR = 1 << 4,
+  CLIP_FAR = 1 << 5,
+};
+
+inline constexpr std::size_t CLIP_PLANE_COUNT = 6;
+
+// Signed distance of a clip space position from a plane, scaled by the position's w, negative outside
+[[nodiscard]] constexpr auto clip_distance(const bonfire::math::float4& p, const std::size_t plane) noexcept -> float {
+  switch (plane) {
+    case 0: return p.x + GUARD_BAND * p.w;
+    case 1: return GUARD_BAND * p.w - p.x;
+    case 2: return p.y + GUARD_BAND * p.w;
+    case 3: return GUARD_BAND * p.w - p.y;
+    case 4: return p.z + p.w;
+    default: return p.w - p.z;
+  }
+}
+
+// Bits of the planes p is outside of, zero when it needs no clipping
+[[nodiscard]] constexpr auto clip_code(const bonfire::math::float4& p) noexcept -> std::uint8_t {
+  std::uint8_t code = 0;
+  for (std::size_t plane = 0; plane < CLIP_PLANE_COUNT; plane++) {
+    if (clip_distance(p, plane) < 0.0f) {
+      code |= static_cast<std::uint8_t>(1u << plane);
+    }
+  }
+  return code;
+}
+
+struct ClipVertex {
+  bonfire::math::float4 position;
+  bonfire::math::float2 uv;
+};
+
+// Every plane a triangle is clipped against can add one vertex
+inline constexpr std::size_t MAX_CLIPPED_VERTICES = 3 + CLIP_PLANE_COUNT;
+
+// Convex polygon a clipped triangle leaves, a fan around its first vertex
+struct ClipPolygon {
+  std::array<ClipVertex, MAX_CLIPPED_VERTICES> vertices{};
+  std::size_t size = 0;
+};
+
+/**
+ * @brief Sutherland-Hodgman clipping of a triangle against the planes in the planes mask, usually the union of the
+ * clip codes of its vertices. Positions and uvs are interpolated linearly in clip space. Edges are always cut from
+ * their inside vertex, so triangles sharing an edge get the same new vertex on it and stay watertight. Returns false
+ * when nothing of the triangle is left.
+ */
+[[nodiscard]] inline auto clip_triangle(const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2,
+                                        const std::uint8_t planes, ClipPolygon& out) noexcept -> bool {
+  namespace bm = bonfire::math;
+
+  ClipPolygon scratch{};
+  // the last plane clipped against has to write to out, start in whichever buffer gets there
+  const auto plane_count = static_cast<std::size_t>(std::popcount(planes));
+  auto* source = plane_count % 2 == 0 ? &out : &scratch;
+  auto* destination = plane_count % 2 == 0 ? &scratch : &out;
+
+  source->vertices[0] = v0;
+  source->vertices[1] = v1;
+  source->vertices[2] = v2;
+  source->size = 3;
+
+  const auto intersect = [](const ClipVertex& inside, const ClipVertex& outside, const float d_inside, const float d_outside) {
+    const auto t = d_inside / (d_inside - d_outside);
+    const auto lerp = [t](const float a, const float b) { return a + (b - a) * t; };
+    return ClipVertex{
+        bm::float4{lerp(inside.position.x, outside.position.x), lerp(inside.position.y, outside.position.y),
+                   lerp(inside.position.z, outside.position.z), lerp(inside.position.w, outside.position.w)},
+        bm::float2{lerp(inside.uv.x, outside.uv.x), lerp(inside.uv.y, outside.uv.y)}};
+  };
+
+  for (std::size_t plane = 0; plane < CLIP_PLANE_COUNT; plane++) {
+    if ((planes & (1u << plane)) == 0) {
+      continue;
+    }
+
+    destination->size = 0;
+    const auto* previous = &source->vertices[source->size - 1];
+    auto d_previous = clip_distance(previous->position, plane);
+
+    for (std::size_t i = 0; i < source->size; i++) {
+      const auto& current = source->vertices[i];
+      const auto d_current = clip_distance(current.position, plane);
+
+      if (d_current >= 0.0f) {
+        if (d_previous < 0.0f) {
+          destination->vertices[destination->size++] = intersect(current, *previous, d_current, d_previous);
+        }
+        destination->vertices[destination->size++] = current;
+      } else if (d_previous >= 0.0f) {
+        destination->vertices[destination->size++] = intersect(*previous, current, d_previous, d_current);
+      }
+
+      previous = &current;
+      d_previous = d_current;
+    }
+
+    if (destination->size < 3) {
+      out.size = 0;
+      return false;
+    }
+    std::swap(source, destination);
+  }
+
+  return true;
+}
+
+}  // namespace swr
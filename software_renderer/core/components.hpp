@@ -3,6 +3,11 @@
 #include <vector>
 
 #include <math/vector3.hpp>
+#include <math/vector4.hpp>
+
+#include "bounds.hpp"
+#include "pods.hpp"
+#include "vertex_buffer.hpp"
 
 namespace swr {
 
@@ -12,19 +17,13 @@ struct TransformComponent {
   bonfire::math::float3 scale{1.0f};
 };
 
-struct Vertex {
-  bonfire::math::float3 pos;
-  bonfire::math::float2 uv;
-
-  constexpr auto operator==(const Vertex& other) const -> bool {
-    return pos == other.pos;
-  }
-};
-
 struct DrawableComponent {
-  std::vector<Vertex> vertices{};
+  VertexBuffer vertices{};
   std::vector<std::uint32_t> indices{};
   Texture texture{};
+  // sphere around the vertices and the plane of every triangle in object space, computed by Renderer::add_entity
+  BoundingSphere bounds{};
+  std::vector<bonfire::math::float4> face_planes{};
 };
 
 } // namespace swr
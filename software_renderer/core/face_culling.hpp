@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <math/vector2.hpp>
+#include <math/vector3.hpp>
+#include <math/vector4.hpp>
+
+#include "vertex_buffer.hpp"
+
+namespace swr {
+
+/**
+ * @brief Plane of every triangle of a mesh in object space. xyz is the normal cross(p1 - p0, p2 - p0), not
+ * normalized, and w the offset, so dot(xyz, p) + w is positive for points p on the side the normal points to.
+ */
+[[nodiscard]] inline auto face_planes(const VertexBuffer& vertices, const std::vector<std::uint32_t>& indices)
+    -> std::vector<bonfire::math::float4> {
+  namespace bm = bonfire::math;
+
+  std::vector<bm::float4> planes;
+  planes.reserve(indices.size() / 3);
+
+  for (std::size_t i = 0; i + 2 < indices.size(); i += 3) {
+    const auto p0 = vertices.position(indices[i]);
+    const auto normal = bm::cross_product(vertices.position(indices[i + 1]) - p0, vertices.position(indices[i + 2]) - p0);
+    planes.emplace_back(normal, -bm::dot_product(normal, p0));
+  }
+
+  return planes;
+}
+
+// Whether a face is seen from its front side from viewpoint, both in the same space
+[[nodiscard]] constexpr auto faces_viewpoint(const bonfire::math::float4& plane, const bonfire::math::float3& viewpoint) noexcept
+    -> bool {
+  return plane.x * viewpoint.x + plane.y * viewpoint.y + plane.z * viewpoint.z + plane.w >= 0.0f;
+}
+
+// Twice the signed area of a screen space triangle, negative for the ones that face away from the camera
+[[nodiscard]] constexpr auto signed_area(const bonfire::math::float2& p0, const bonfire::math::float2& p1,
+                                         const bonfire::math::float2& p2) noexcept -> float {
+  return (p1.x - p0.x) * (p2.y - p0.y) - (p2.x - p0.x) * (p1.y - p0.y);
+}
+
+}  // namespace swr
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+#include <math/matrix4.hpp>
+#include <math/vector3.hpp>
+#include <math/vector4.hpp>
+
+#include "bounds.hpp"
+
+namespace swr {
+
+// Where a volume lies relative to the frustum
+enum class FrustumTest : std::uint8_t {
+  Outside,       // nothing of it can be visible
+  Intersecting,  // it may cross one or more of the planes
+  Inside,        // all of it is within every plane, its triangles need no clipping
+};
+
+/**
+ * The six planes of the view volume, taken from the matrix that brings positions into clip space
+ * (-w <= x, y, z <= w). Plane normals point inwards and are normalized, so a plane evaluates to the distance of a
+ * point from it.
+ */
+class Frustum {
+ public:
+  Frustum() noexcept = default;
+
+  explicit Frustum(const bonfire::math::Mat4& clip_matrix) noexcept {
+    namespace bm = bonfire::math;
+
+    // rows of the matrix, which is stored by columns
+    const auto& c0 = clip_matrix.column(0);
+    const auto& c1 = clip_matrix.column(1);
+    const auto& c2 = clip_matrix.column(2);
+    const auto& c3 = clip_matrix.column(3);
+    const bm::float4 row_x{c0.x, c1.x, c2.x, c3.x};
+    const bm::float4 row_y{c0.y, c1.y, c2.y, c3.y};
+    const bm::float4 row_z{c0.z, c1.z, c2.z, c3.z};
+    const bm::float4 row_w{c0.w, c1.w, c2.w, c3.w};
+
+    const auto add = [](const bm::float4& a, const bm::float4& b, const float sign) {
+      return bm::float4{a.x + sign * b.x, a.y + sign * b.y, a.z + sign * b.z, a.w + sign * b.w};
+    };
+
+    // left, right, bottom, top, near, far
+    planes_ = {add(row_w, row_x, 1.0f), add(row_w, row_x, -1.0f), add(row_w, row_y, 1.0f),
+               add(row_w, row_y, -1.0f), add(row_w, row_z, 1.0f), add(row_w, row_z, -1.0f)};
+
+    for (auto& plane : planes_) {
+      const auto length = std::sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+      if (length != 0.0f) {
+        plane = bm::float4{plane.x / length, plane.y / length, plane.z / length, plane.w / length};
+      }
+    }
+  }
+
+  [[nodiscard]] auto classify(const BoundingSphere& sphere) const noexcept -> FrustumTest {
+    auto result = FrustumTest::Inside;
+    for (const auto& plane : planes_) {
+      const auto distance = plane.x * sphere.center.x + plane.y * sphere.center.y + plane.z * sphere.center.z + plane.w;
+      if (distance < -sphere.radius) {
+        return FrustumTest::Outside;
+      }
+      if (distance < sphere.radius) {
+        result = FrustumTest::Intersecting;
+      }
+    }
+    return result;
+  }
+
+ private:
+  std::array<bonfire::math::float4, 6> planes_{};
+};
+
+}  // namespace swr
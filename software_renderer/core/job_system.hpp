@@ -0,0 +1,278 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace swr {
+
+/**
+ * Persistent work stealing scheduler.
+ *
+ * Every worker owns a deque: it pushes and pops its own jobs at the back, so the work it just split off stays hot
+ * in its cache, while idle workers steal from the front of the others, taking the oldest and usually largest
+ * pieces. Threads that are not workers share one more deque. A thread waiting for a job never blocks while there
+ * is something to run, it runs queued jobs itself until the one it waits for has finished, so the main thread takes
+ * part in the work and nested parallel_for calls cannot deadlock.
+ *
+ * A system of size N spawns N - 1 threads, the thread that waits is the N-th.
+ */
+class JobSystem {
+  struct JobNode {
+    std::function<void()> fn;
+    std::atomic<std::size_t> unfinished_dependencies{0};
+    std::atomic<bool> done{false};
+
+    // guards finished and dependents, a dependent registers itself only while the job has not finished
+    std::mutex mutex{};
+    bool finished = false;
+    std::vector<std::shared_ptr<JobNode>> dependents{};
+  };
+
+ public:
+  // A scheduled job, wait on it or pass it as a dependency of later jobs
+  using JobHandle = std::shared_ptr<JobNode>;
+
+  explicit JobSystem(const std::size_t thread_count = std::max(1u, std::thread::hardware_concurrency()))
+      : queues_(thread_count) {
+    for (std::size_t i = 1; i < thread_count; i++) {
+      workers_.emplace_back([this, i] { worker_loop(i); });
+    }
+  }
+
+  JobSystem(const JobSystem&) = delete;
+  auto operator=(const JobSystem&) -> JobSystem& = delete;
+
+  ~JobSystem() {
+    {
+      std::lock_guard lock{sleep_mutex_};
+      stopping_ = true;
+    }
+    wake_cv_.notify_all();
+
+    for (auto& worker : workers_) {
+      worker.join();
+    }
+  }
+
+  [[nodiscard]] auto size() const noexcept -> std::size_t { return workers_.size() + 1; }
+
+  /**
+   * @brief Schedules fn to run once every job in dependencies has finished, finished or empty handles are
+   * satisfied already. This is how frame stages are chained without waiting on the calling thread in between.
+   */
+  auto schedule(std::function<void()> fn, std::initializer_list<JobHandle> dependencies = {}) -> JobHandle {
+    auto node = std::make_shared<JobNode>();
+    node->fn = std::move(fn);
+    // the extra count is released below, so the job cannot start before all dependencies are registered
+    node->unfinished_dependencies.store(1, std::memory_order_relaxed);
+
+    for (const auto& dependency : dependencies) {
+      if (dependency == nullptr) {
+        continue;
+      }
+
+      std::lock_guard lock{dependency->mutex};
+      if (!dependency->finished) {
+        node->unfinished_dependencies.fetch_add(1, std::memory_order_relaxed);
+        dependency->dependents.push_back(node);
+      }
+    }
+
+    release(node);
+    return node;
+  }
+
+  // Runs queued jobs on the calling thread until job has finished
+  void wait(const JobHandle& job) {
+    if (job != nullptr) {
+      help_until([&] { return job->done.load(std::memory_order_acquire); });
+    }
+  }
+
+  /**
+   * @brief Calls fn(i) for every i in [0, count) and returns once all calls have finished. The range is split into
+   * jobs of grain indices that any worker may run, so fn must not depend on which thread runs it.
+   */
+  template <typename Fn>
+  void parallel_for(const std::size_t count, const std::size_t grain, Fn&& fn) {
+    const auto chunk = std::max<std::size_t>(grain, 1);
+    if (workers_.empty() || count <= chunk) {
+      for (std::size_t i = 0; i < count; i++) {
+        fn(i);
+      }
+      return;
+    }
+
+    const auto job_count = (count + chunk - 1) / chunk;
+    std::atomic<std::size_t> remaining{job_count};
+
+    // the calling thread runs the first chunk itself right away, the rest is up for grabs
+    push_jobs(job_count - 1, [&](const std::size_t k) {
+      // pushed last to first, so the own thread pops them in order and thieves take the far end
+      const auto job = job_count - 1 - k;
+      return [&, job] {
+        const auto end = std::min(count, (job + 1) * chunk);
+        for (auto i = job * chunk; i < end; i++) {
+          fn(i);
+        }
+        remaining.fetch_sub(1, std::memory_order_release);
+      };
+    });
+
+    for (std::size_t i = 0; i < chunk; i++) {
+      fn(i);
+    }
+    remaining.fetch_sub(1, std::memory_order_release);
+
+    help_until([&] { return remaining.load(std::memory_order_acquire) == 0; });
+  }
+
+  // parallel_for with one index per job
+  template <typename Fn>
+  void parallel_for(const std::size_t count, Fn&& fn) {
+    parallel_for(count, 1, std::forward<Fn>(fn));
+  }
+
+ private:
+  struct WorkQueue {
+    std::mutex mutex{};
+    std::deque<std::function<void()>> jobs{};
+  };
+
+  // the queue of the calling thread, threads that are not workers share queue 0
+  [[nodiscard]] auto queue_index() const noexcept -> std::size_t {
+    return current_system == this ? current_worker : 0;
+  }
+
+  // Drops one pending dependency of node and queues it once there are none left
+  void release(const JobHandle& node) {
+    if (node->unfinished_dependencies.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+      return;
+    }
+
+    push_jobs(1, [&](std::size_t) {
+      return [this, node] {
+        node->fn();
+        finish(node);
+      };
+    });
+  }
+
+  void finish(const JobHandle& node) {
+    std::vector<JobHandle> dependents;
+    {
+      std::lock_guard lock{node->mutex};
+      node->finished = true;
+      dependents.swap(node->dependents);
+    }
+    node->done.store(true, std::memory_order_release);
+
+    for (const auto& dependent : dependents) {
+      release(dependent);
+    }
+  }
+
+  // Pushes make_job(k) for k in [0, count) to the queue of the calling thread and wakes workers for them
+  template <typename MakeJobFn>
+  void push_jobs(const std::size_t count, MakeJobFn&& make_job) {
+    auto& queue = queues_[queue_index()];
+    {
+      std::lock_guard lock{queue.mutex};
+      for (std::size_t k = 0; k < count; k++) {
+        queue.jobs.push_back(make_job(k));
+      }
+      // counted under the queue lock, a job is never taken before it was counted
+      queued_.fetch_add(count, std::memory_order_release);
+    }
+
+    {
+      // taking the lock orders the count with a worker that is about to sleep, so it cannot miss the wake up
+      std::lock_guard lock{sleep_mutex_};
+    }
+    if (count == 1) {
+      wake_cv_.notify_one();
+    } else {
+      wake_cv_.notify_all();
+    }
+  }
+
+  // Pops from the back of the own queue, then steals from the front of the others
+  auto take_job() -> std::optional<std::function<void()>> {
+    const auto own = queue_index();
+
+    for (std::size_t k = 0; k < queues_.size(); k++) {
+      auto& queue = queues_[(own + k) % queues_.size()];
+      std::lock_guard lock{queue.mutex};
+      if (queue.jobs.empty()) {
+        continue;
+      }
+
+      std::function<void()> job;
+      if (k == 0) {
+        job = std::move(queue.jobs.back());
+        queue.jobs.pop_back();
+      } else {
+        job = std::move(queue.jobs.front());
+        queue.jobs.pop_front();
+      }
+      queued_.fetch_sub(1, std::memory_order_relaxed);
+      return job;
+    }
+
+    return std::nullopt;
+  }
+
+  template <typename DoneFn>
+  void help_until(DoneFn&& is_done) {
+    while (!is_done()) {
+      if (auto job = take_job()) {
+        (*job)();
+      } else {
+        // the rest is running on other threads
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  void worker_loop(const std::size_t index) {
+    current_system = this;
+    current_worker = index;
+
+    for (;;) {
+      if (auto job = take_job()) {
+        (*job)();
+        continue;
+      }
+
+      std::unique_lock lock{sleep_mutex_};
+      wake_cv_.wait(lock, [this] { return stopping_ || queued_.load(std::memory_order_acquire) > 0; });
+      if (stopping_) {
+        return;
+      }
+    }
+  }
+
+ private:
+  // the system and worker index of the calling thread, unset on threads that are not workers
+  static inline thread_local const JobSystem* current_system = nullptr;
+  static inline thread_local std::size_t current_worker = 0;
+
+  std::vector<WorkQueue> queues_;
+  std::vector<std::thread> workers_{};
+  std::atomic<std::size_t> queued_{0};
+  std::mutex sleep_mutex_{};
+  std::condition_variable wake_cv_{};
+  bool stopping_ = false;
+};
+
+}  // namespace swr
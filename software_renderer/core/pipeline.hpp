@@ -0,0 +1,262 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "pods.hpp"
+#include "simd.hpp"
+#include "texture.hpp"
+
+namespace swr {
+
+/*
+ * Pixel pipelines
+ *
+ * A pipeline decides what a triangle writes to the pixels the rasterizer found covered. A shader produces the
+ * color, a depth test decides whether a pixel is written at all and a blend mode combines the color with the one
+ * already in the color buffer. All three are template parameters, every combination compiles to its own fully
+ * inlined span loop and nothing about them is decided per pixel.
+ */
+
+// One row of the render targets, indexed with absolute x positions
+struct SpanTarget {
+  std::uint32_t* color;
+  const std::uint32_t* ids;
+  const float* depth;
+  int y;
+};
+
+// Colors pixels, row(y) does the per row setup that operator() then uses for every pixel of a span
+template <typename T>
+concept PixelShader = requires(const T& shader, const typename T::Row& row, const int x, const int y) {
+  { shader.row(y) } -> std::same_as<typename T::Row>;
+  { shader(row, x) } -> std::same_as<std::uint32_t>;
+  // every pixel gets the same color
+  { T::CONSTANT } -> std::convertible_to<bool>;
+};
+
+// Shader that colors a whole span [x0, x1) of a row at once, given it may write every pixel of it
+template <typename T>
+concept SpanShader = PixelShader<T> && requires(const T& shader, const typename T::Row& row, std::uint32_t* out) {
+  shader.shade_span(row, 0, 0, out);
+};
+
+// Decides per pixel whether it is written, looking at the id or depth buffer of the row
+template <typename T>
+concept DepthTest = requires(const T& test, const SpanTarget& target, const int x) {
+  { test(target, x) } -> std::same_as<bool>;
+  { T::ALWAYS_PASSES } -> std::convertible_to<bool>;
+};
+
+// Combines a shaded color with the one in the color buffer
+template <typename T>
+concept BlendMode = requires(const std::uint32_t source, const std::uint32_t destination) {
+  { T::blend(source, destination) } -> std::same_as<std::uint32_t>;
+  { T::READS_DESTINATION } -> std::convertible_to<bool>;
+};
+
+// Writes pixels [x0, x1) of a row, returns how many were written
+template <typename T>
+concept SpanPipeline = requires(const T& pipeline, const SpanTarget& target, const int x0, const int x1) {
+  { pipeline.shade_span(target, x0, x1) } -> std::same_as<std::size_t>;
+};
+
+struct FlatShader {
+  static constexpr bool CONSTANT = true;
+
+  struct Row {};
+
+  std::uint32_t color;
+
+  [[nodiscard]] auto row(int) const noexcept -> Row { return {}; }
+  [[nodiscard]] auto operator()(const Row&, int) const noexcept -> std::uint32_t { return color; }
+};
+
+// Linear attribute over the screen, dx * x + dy * y + c is its value at the center of pixel (x, y)
+struct AttributePlane {
+  float dx = 0.0f;
+  float dy = 0.0f;
+  float c = 0.0f;
+
+  // evaluated per row and then per pixel, so the same pixel gets the same value whatever span it is drawn in
+  [[nodiscard]] auto row(const int y) const noexcept -> float { return dy * static_cast<float>(y) + c; }
+  [[nodiscard]] auto at(const float row_value, const int x) const noexcept -> float { return dx * static_cast<float>(x) + row_value; }
+};
+
+struct UvPlanes {
+  AttributePlane u, v;
+};
+
+// Plane of an attribute with the values a0, a1 and a2 at the 28.4 fixed point vertices of a triangle
+[[nodiscard]] inline auto attribute_plane(const Vertex2& v0, const Vertex2& v1, const Vertex2& v2, const double a0,
+                                          const double a1, const double a2) noexcept -> AttributePlane {
+  const auto dx1 = static_cast<double>(v1.x - v0.x);
+  const auto dy1 = static_cast<double>(v1.y - v0.y);
+  const auto dx2 = static_cast<double>(v2.x - v0.x);
+  const auto dy2 = static_cast<double>(v2.y - v0.y);
+
+  const auto determinant = dx1 * dy2 - dx2 * dy1;
+  if (determinant == 0.0) {
+    return {};
+  }
+
+  // gradient per fixed point unit, then moved to whole pixels sampled at their centers
+  const auto gx = ((a1 - a0) * dy2 - (a2 - a0) * dy1) / determinant;
+  const auto gy = ((a2 - a0) * dx1 - (a1 - a0) * dx2) / determinant;
+  constexpr double HALF = SUBPIXEL_SCALE / 2.0;
+
+  return AttributePlane{static_cast<float>(gx * SUBPIXEL_SCALE), static_cast<float>(gy * SUBPIXEL_SCALE),
+                        static_cast<float>(a0 + gx * (HALF - v0.x) + gy * (HALF - v0.y))};
+}
+
+// Texture coordinate planes of a triangle with 28.4 fixed point vertices
+[[nodiscard]] inline auto uv_planes(const Vertex2& v0, const Vertex2& v1, const Vertex2& v2) noexcept -> UvPlanes {
+  return UvPlanes{attribute_plane(v0, v1, v2, v0.u, v1.u, v2.u), attribute_plane(v0, v1, v2, v0.v, v1.v, v2.v)};
+}
+
+/**
+ * Picks the mip level whose texel density matches the screen. Texturing is affine so the uv derivatives are
+ * constant over a triangle, the ratio of its area in texels to its area in pixels is their determinant.
+ */
+[[nodiscard]] inline auto select_mip(const Vertex2& v0, const Vertex2& v1, const Vertex2& v2, const Texture& texture)
+    -> const Texture& {
+  if (texture.mips.empty()) {
+    return texture;
+  }
+
+  // vertex positions are fixed point, scale their area back to pixels
+  const auto pixel_area = std::abs(static_cast<float>(v1.x - v0.x) * static_cast<float>(v2.y - v0.y) -
+                                   static_cast<float>(v2.x - v0.x) * static_cast<float>(v1.y - v0.y)) /
+                          static_cast<float>(SUBPIXEL_SCALE * SUBPIXEL_SCALE);
+  const auto texel_area = std::abs(((v1.u - v0.u) * (v2.v - v0.v) - (v2.u - v0.u) * (v1.v - v0.v)) *
+                                   static_cast<float>(texture.width) * static_cast<float>(texture.height));
+
+  if (pixel_area == 0.0f || texel_area <= pixel_area) {
+    return texture;
+  }
+
+  // every level halves the texel density in both directions
+  const auto lod = static_cast<std::size_t>(0.5f * std::log2(texel_area / pixel_area));
+  if (lod == 0) {
+    return texture;
+  }
+  return texture.mips[std::min(lod, texture.mips.size()) - 1];
+}
+
+template <typename Sampler>
+struct TextureShader {
+  static constexpr bool CONSTANT = false;
+
+  struct Row {
+    float u, v;
+  };
+
+  Sampler sample;
+  UvPlanes uv;
+
+  [[nodiscard]] auto row(const int y) const noexcept -> Row { return Row{uv.u.row(y), uv.v.row(y)}; }
+
+  [[nodiscard]] auto operator()(const Row& row, const int x) const noexcept -> std::uint32_t {
+    return sample(uv.u.at(row.u, x), uv.v.at(row.v, x));
+  }
+};
+
+// Calls fn with the TextureShader of a triangle, mip level, filter and wrap mode are resolved here once per triangle
+template <typename Fn>
+void with_texture_shader(const Vertex2& v0, const Vertex2& v1, const Vertex2& v2, const Texture& texture,
+                         const SamplerState& sampler, Fn&& fn) {
+  const auto& mip = select_mip(v0, v1, v2, texture);
+  const auto uv = uv_planes(v0, v1, v2);
+
+  with_sampler(mip, sampler, [&](const auto& sample) { fn(TextureShader<std::remove_cvref_t<decltype(sample)>>{sample, uv}); });
+}
+
+/**
+ * Multiplies the colors of another shader with a light factor (see light_factor). Whole spans are shaded first and
+ * lit with the SIMD kernel right after, while they are still in the cache, single pixels give the same colors.
+ */
+template <PixelShader Shader>
+struct LitShader {
+  static constexpr bool CONSTANT = Shader::CONSTANT;
+
+  using Row = typename Shader::Row;
+
+  Shader shader;
+  std::uint32_t light;
+
+  [[nodiscard]] auto row(const int y) const noexcept -> Row { return shader.row(y); }
+
+  [[nodiscard]] auto operator()(const Row& row, const int x) const noexcept -> std::uint32_t {
+    return simd::modulate_color(shader(row, x), light);
+  }
+
+  void shade_span(const Row& row, const int x0, const int x1, std::uint32_t* out) const noexcept {
+    for (int x = x0; x < x1; x++) {
+      out[x] = shader(row, x);
+    }
+    simd::modulate_colors(out + x0, static_cast<std::size_t>(x1 - x0), light);
+  }
+};
+
+struct AlwaysPass {
+  static constexpr bool ALWAYS_PASSES = true;
+
+  [[nodiscard]] auto operator()(const SpanTarget&, int) const noexcept -> bool { return true; }
+};
+
+/**
+ * Second pass of a depth prepass, only the pixels where the surface is at the depth the first pass left are written.
+ * The first pass evaluates depths along its spans (see simd::fill_depth_tested), which rounds differently than the
+ * plane does here, so depths within TOLERANCE of the stored one count as equal. Nothing is in front of the stored
+ * depth, which makes that a less-or-equal test.
+ */
+struct DepthEqual {
+  static constexpr bool ALWAYS_PASSES = false;
+  // a few steps of float precision at the far end of the depth range
+  static constexpr float TOLERANCE = 1e-6f;
+
+  AttributePlane plane;
+
+  [[nodiscard]] auto operator()(const SpanTarget& target, const int x) const noexcept -> bool {
+    return plane.at(plane.row(target.y), x) <= target.depth[x] + TOLERANCE;
+  }
+};
+
+struct Replace {
+  static constexpr bool READS_DESTINATION = false;
+
+  [[nodiscard]] static constexpr auto blend(const std::uint32_t source, std::uint32_t) noexcept -> std::uint32_t { return source; }
+};
+
+template <PixelShader Shader, DepthTest Depth = AlwaysPass, BlendMode Blend = Replace>
+struct PixelPipeline {
+  Shader shader;
+  Depth depth{};
+
+  auto shade_span(const SpanTarget& target, const int x0, const int x1) const -> std::size_t {
+    const auto row = shader.row(target.y);
+
+    if constexpr (Shader::CONSTANT && Depth::ALWAYS_PASSES && !Blend::READS_DESTINATION) {
+      std::fill_n(target.color + x0, x1 - x0, Blend::blend(shader(row, x0), 0));
+      return static_cast<std::size_t>(x1 - x0);
+    } else if constexpr (SpanShader<Shader> && Depth::ALWAYS_PASSES && std::same_as<Blend, Replace>) {
+      shader.shade_span(row, x0, x1, target.color);
+      return static_cast<std::size_t>(x1 - x0);
+    } else {
+      std::size_t written = 0;
+      for (int x = x0; x < x1; x++) {
+        if (depth(target, x)) {
+          target.color[x] = Blend::blend(shader(row, x), target.color[x]);
+          written++;
+        }
+      }
+      return written;
+    }
+  }
+};
+
+}  // namespace swr
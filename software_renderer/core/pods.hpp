@@ -1,32 +1,96 @@
 #pragma once
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include <math/vector2.hpp>
 #include <math/vector3.hpp>
 
 namespace swr {
 
+// Sub-pixel precision of the triangle rasterizers, vertex positions are 28.4 fixed point
+inline constexpr int SUBPIXEL_BITS = 4;
+inline constexpr int SUBPIXEL_SCALE = 1 << SUBPIXEL_BITS;
+
+// Converts a screen position in pixels to fixed point. Positions far off screen are clamped, which keeps the
+// products of the triangle setup within 64 bits
+[[nodiscard]] inline auto to_fixed(const float pixels) noexcept -> int {
+  constexpr float LIMIT = static_cast<float>(1 << 26);
+  return static_cast<int>(std::lround(std::clamp(pixels * static_cast<float>(SUBPIXEL_SCALE), -LIMIT, LIMIT)));
+}
+
+// Rasterizer vertex, x and y are the screen position in 28.4 fixed point
 struct Vertex2 {
   int x, y;
   float u, v;
 
   explicit Vertex2(const bonfire::math::float2& pos, const bonfire::math::float2& uv) noexcept
-      : x{static_cast<int>(pos.x)}, y{static_cast<int>(pos.y)}, u{uv.x}, v{uv.y} {}
-  explicit Vertex2(const int px, const int py) noexcept : x{px}, y{py}, u{}, v{} {}
+      : x{to_fixed(pos.x)}, y{to_fixed(pos.y)}, u{uv.x}, v{uv.y} {}
+  explicit Vertex2(const float px, const float py) noexcept : x{to_fixed(px)}, y{to_fixed(py)}, u{}, v{} {}
   Vertex2() noexcept = default;
 };
 
-inline auto operator+(const Vertex2& vec1, const Vertex2& vec2) noexcept -> Vertex2 { return Vertex2{vec1.x + vec2.x, vec1.y + vec2.y}; }
+// Screen space rectangle, min is inclusive and max is exclusive
+struct Rect {
+  int min_x, min_y, max_x, max_y;
+
+  [[nodiscard]] constexpr auto empty() const noexcept -> bool { return min_x >= max_x || min_y >= max_y; }
 
-inline auto operator-(const Vertex2& vec1, const Vertex2& vec2) noexcept -> Vertex2 { return Vertex2{vec1.x - vec2.x, vec1.y - vec2.y}; }
+  [[nodiscard]] constexpr auto contains(const int x, const int y) const noexcept -> bool {
+    return x >= min_x && x < max_x && y >= min_y && y < max_y;
+  }
+};
+
+[[nodiscard]] constexpr auto intersect(const Rect& lhs, const Rect& rhs) noexcept -> Rect {
+  return Rect{std::max(lhs.min_x, rhs.min_x), std::max(lhs.min_y, rhs.min_y), std::min(lhs.max_x, rhs.max_x),
+              std::min(lhs.max_y, rhs.max_y)};
+}
 
 struct Light {
   bonfire::math::float3 direction;
 };
 
+// Per channel factor of a white light shining with intensity, for simd::modulate_color. Intensity is clamped to [0, 1]
+[[nodiscard]] inline auto light_factor(const float intensity) noexcept -> std::uint32_t {
+  const auto level = static_cast<std::uint32_t>(std::lround(std::clamp(intensity, 0.0f, 1.0f) * 255.0f));
+  return 0xFF000000 | (level << 16) | (level << 8) | level;
+}
+
+// Order the texels are stored in, see texture.hpp for the address functions
+enum class TextureLayout : std::uint8_t {
+  Linear,  // row-major
+  Morton,  // Z-order curve, needs power of two dimensions
+};
+
+enum class TextureWrap : std::uint8_t {
+  Repeat,
+  Clamp,
+  Mirror,
+};
+
+enum class TextureFilter : std::uint8_t {
+  Nearest,
+  Bilinear,
+};
+
+struct SamplerState {
+  TextureWrap wrap = TextureWrap::Repeat;
+  TextureFilter filter = TextureFilter::Nearest;
+};
+
 struct Texture {
   std::uint32_t width{};
   std::uint32_t height{};
+  TextureLayout layout = TextureLayout::Linear;
+  // both dimensions are powers of two, lets the sampler wrap with masks
+  bool power_of_two = false;
 
   std::vector<std::uint32_t> texels{};
+
+  // mip chain, mips[0] is half the size of this texture and so on down to 1x1. Empty if not generated
+  std::vector<Texture> mips{};
 };
 
 } // namespace swr
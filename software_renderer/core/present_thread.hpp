@@ -0,0 +1,84 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "canvas.hpp"
+
+namespace swr {
+
+/**
+ * Dedicated thread that hands finished frames to a present function, so uploading and presenting a frame
+ * overlaps with rasterizing the next one.
+ *
+ * A submitted frame is read by the present thread until wait_idle returns, the caller must not draw into it before.
+ */
+class PresentThread {
+ public:
+  using PresentFn = std::function<void(const ColorBuffer&)>;
+
+  explicit PresentThread(PresentFn present) : present_{std::move(present)}, thread_{[this] { run(); }} {}
+
+  PresentThread(const PresentThread&) = delete;
+  auto operator=(const PresentThread&) -> PresentThread& = delete;
+
+  ~PresentThread() {
+    {
+      std::lock_guard lock{mutex_};
+      stopping_ = true;
+    }
+    wake_cv_.notify_one();
+    thread_.join();
+  }
+
+  void submit(const ColorBuffer& frame) {
+    {
+      std::lock_guard lock{mutex_};
+      pending_ = &frame;
+    }
+    wake_cv_.notify_one();
+  }
+
+  // Blocks until every submitted frame has been presented
+  void wait_idle() {
+    std::unique_lock lock{mutex_};
+    idle_cv_.wait(lock, [this] { return pending_ == nullptr && !presenting_; });
+  }
+
+ private:
+  void run() {
+    std::unique_lock lock{mutex_};
+
+    for (;;) {
+      wake_cv_.wait(lock, [this] { return stopping_ || pending_ != nullptr; });
+      if (pending_ == nullptr) {
+        return;
+      }
+
+      const auto* frame = pending_;
+      pending_ = nullptr;
+      presenting_ = true;
+
+      lock.unlock();
+      present_(*frame);
+      lock.lock();
+
+      presenting_ = false;
+      idle_cv_.notify_all();
+    }
+  }
+
+ private:
+  PresentFn present_;
+  std::mutex mutex_{};
+  std::condition_variable wake_cv_{};
+  std::condition_variable idle_cv_{};
+  const ColorBuffer* pending_ = nullptr;
+  bool presenting_ = false;
+  bool stopping_ = false;
+  std::thread thread_;
+};
+
+}  // namespace swr
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "canvas.hpp"
+#include "render_options.hpp"
+
+namespace swr {
+
+/**
+ * Where finished frames go. The renderer only talks to this interface, so it runs the same with a window
+ * (SdlPresenter) or without one (HeadlessPresenter).
+ */
+class Presenter {
+ public:
+  Presenter() = default;
+  Presenter(const Presenter&) = delete;
+  auto operator=(const Presenter&) -> Presenter& = delete;
+  virtual ~Presenter() = default;
+
+  // Creates whatever is needed to show frames of the given size
+  [[nodiscard]] virtual auto initialize(int width, int height) -> bool = 0;
+
+  // Handles pending window and input events, returns false once the user asked to quit
+  [[nodiscard]] virtual auto process_events(RenderOptions& options) -> bool = 0;
+
+  // Shows a finished frame, called from the present thread when presenting asynchronously and supported
+  virtual void present(const ColorBuffer& frame) = 0;
+
+  // Whether present may be called from a thread other than the one that initialized it and processes events. Without
+  // it, asynchronous presents run on the main thread, overlapped with the job workers rasterizing the next frame
+  [[nodiscard]] virtual auto supports_async_present() const -> bool { return false; }
+
+  virtual void shutdown() {}
+};
+
+/**
+ * Presenter without a window, event loop or vsync. Frames are handed to a callback, if any, which makes it
+ * suitable for offline rendering and for measuring pure rendering throughput.
+ */
+class HeadlessPresenter final : public Presenter {
+ public:
+  using FrameCallback = std::function<void(const ColorBuffer& frame, int width, int height)>;
+
+  explicit HeadlessPresenter(FrameCallback on_frame = {}) : on_frame_{std::move(on_frame)} {}
+
+  [[nodiscard]] auto initialize(const int width, const int height) -> bool override {
+    width_ = width;
+    height_ = height;
+    return true;
+  }
+
+  [[nodiscard]] auto process_events(RenderOptions&) -> bool override { return true; }
+
+  // the callback is the only thing touched by present
+  [[nodiscard]] auto supports_async_present() const -> bool override { return true; }
+
+  void present(const ColorBuffer& frame) override {
+    if (on_frame_) {
+      on_frame_(frame, width_, height_);
+    }
+  }
+
+ private:
+  FrameCallback on_frame_;
+  int width_ = 0;
+  int height_ = 0;
+};
+
+// Writes an ARGB frame as a binary PPM, alpha is dropped
+inline auto write_ppm(const std::filesystem::path& path, const ColorBuffer& frame, const int width, const int height) -> bool {
+  std::ofstream file{path, std::ios::binary};
+  if (!file) {
+    std::cerr << "Could not open " << path << " for writing" << std::endl;
+    return false;
+  }
+
+  file << "P6\n" << width << " " << height << "\n255\n";
+
+  std::vector<char> row(static_cast<std::size_t>(width) * 3);
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      const auto color = frame[static_cast<std::size_t>(width) * y + x];
+      row[3 * x + 0] = static_cast<char>((color >> 16) & 0xFF);
+      row[3 * x + 1] = static_cast<char>((color >> 8) & 0xFF);
+      row[3 * x + 2] = static_cast<char>(color & 0xFF);
+    }
+    file.write(row.data(), static_cast<std::streamsize>(row.size()));
+  }
+
+  return static_cast<bool>(file);
+}
+
+// HeadlessPresenter callback writing every frame to directory/frame_00000.ppm, frame_00001.ppm, ...
+inline auto write_frames_to(std::filesystem::path directory) -> HeadlessPresenter::FrameCallback {
+  return [directory = std::move(directory), frame_index = 0](const ColorBuffer& frame, const int width, const int height) mutable {
+    char name[32];
+    std::snprintf(name, sizeof(name), "frame_%05d.ppm", frame_index++);
+    write_ppm(directory / name, frame, width, height);
+  };
+}
+
+}  // namespace swr
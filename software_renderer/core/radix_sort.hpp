@@ -0,0 +1,126 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "job_system.hpp"
+
+namespace swr {
+
+// Maps a float to an unsigned key with the same order, negative values flip entirely, positive ones flip the sign
+[[nodiscard]] constexpr auto sortable_key(const float value) noexcept -> std::uint32_t {
+  const auto bits = std::bit_cast<std::uint32_t>(value);
+  return (bits & 0x80000000u) != 0 ? ~bits : bits | 0x80000000u;
+}
+
+// Sort entry, the key in the high half and the index of what it belongs to in the low half
+[[nodiscard]] constexpr auto make_sort_entry(const std::uint32_t key, const std::uint32_t index) noexcept -> std::uint64_t {
+  return (std::uint64_t{key} << 32) | index;
+}
+
+[[nodiscard]] constexpr auto sort_entry_index(const std::uint64_t entry) noexcept -> std::uint32_t {
+  return static_cast<std::uint32_t>(entry);
+}
+
+/**
+ * LSD radix sort of entries by their 32 bit key, one pass per key byte. Entries with equal keys keep their order,
+ * so the result does not depend on how the work was split. Passes whose byte is the same for every key are
+ * skipped, which for depths clustered in a narrow range usually leaves two or three of the four.
+ *
+ * With a job system and at least PARALLEL_THRESHOLD entries every pass is split into blocks: the blocks count
+ * their digits in parallel, a prefix sum over (digit, block) gives every block its own output ranges and the blocks
+ * scatter in parallel. The scratch buffer and histograms are kept for the next call.
+ */
+class RadixSorter {
+ public:
+  static constexpr std::size_t PARALLEL_THRESHOLD = 64 * 1024;
+  // entries per block, large enough that a block's histogram is cheap next to its scatter
+  static constexpr std::size_t BLOCK_SIZE = 16 * 1024;
+
+  void sort(std::vector<std::uint64_t>& entries, JobSystem* jobs = nullptr) {
+    const auto count = entries.size();
+    if (count <= 1) {
+      return;
+    }
+
+    scratch_.resize(count);
+    const bool parallel = jobs != nullptr && jobs->size() > 1 && count >= PARALLEL_THRESHOLD;
+    const auto block_count = parallel ? (count + BLOCK_SIZE - 1) / BLOCK_SIZE : 1;
+    const auto block_size = parallel ? BLOCK_SIZE : count;
+    histograms_.resize(block_count);
+
+    auto* source = entries.data();
+    auto* destination = scratch_.data();
+
+    for (int shift = 32; shift < 64; shift += 8) {
+      const auto digit = [shift](const std::uint64_t entry) { return static_cast<std::size_t>((entry >> shift) & 0xFF); };
+
+      const auto count_block = [&](const std::size_t block) {
+        auto& histogram = histograms_[block];
+        histogram.fill(0);
+        const auto end = std::min(count, (block + 1) * block_size);
+        for (auto i = block * block_size; i < end; i++) {
+          histogram[digit(source[i])]++;
+        }
+      };
+
+      if (parallel) {
+        jobs->parallel_for(block_count, count_block);
+      } else {
+        count_block(0);
+      }
+
+      // every key has the same byte here, the pass would not move anything
+      std::size_t same_digit = 0;
+      for (const auto& histogram : histograms_) {
+        same_digit += histogram[digit(source[0])];
+      }
+      if (same_digit == count) {
+        continue;
+      }
+
+      // histograms become the first output position of every (digit, block), digits major so equal keys stay in order
+      std::size_t offset = 0;
+      for (std::size_t d = 0; d < 256; d++) {
+        for (auto& histogram : histograms_) {
+          const auto n = histogram[d];
+          histogram[d] = offset;
+          offset += n;
+        }
+      }
+
+      const auto scatter_block = [&](const std::size_t block) {
+        auto& positions = histograms_[block];
+        const auto end = std::min(count, (block + 1) * block_size);
+        for (auto i = block * block_size; i < end; i++) {
+          destination[positions[digit(source[i])]++] = source[i];
+        }
+      };
+
+      if (parallel) {
+        jobs->parallel_for(block_count, scatter_block);
+      } else {
+        scatter_block(0);
+      }
+
+      std::swap(source, destination);
+    }
+
+    // an odd number of passes left the result in the scratch buffer
+    if (source != entries.data()) {
+      entries.swap(scratch_);
+    }
+  }
+
+ private:
+  using Histogram = std::array<std::size_t, 256>;
+
+  std::vector<std::uint64_t> scratch_{};
+  std::vector<Histogram> histograms_{};
+};
+
+}  // namespace swr
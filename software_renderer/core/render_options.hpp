@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+
+#include "pods.hpp"
+
+namespace swr {
+
+// How surfaces are shaded. Forward and VisibilityBuffer produce the same image, ordered by the painters algorithm,
+// DepthPrepass resolves visibility per pixel instead and differs where that order is wrong
+enum class ShadingMode : std::uint8_t {
+  Forward,           // shade every covered pixel of every triangle as it is rasterized
+  VisibilityBuffer,  // record which triangle covers each pixel, then shade every pixel once
+  DepthPrepass,      // write the depth of every triangle first, then shade only the pixels at the nearest depth
+};
+
+// Where triangles facing away from the camera are dropped
+enum class FaceCulling : std::uint8_t {
+  None,
+  ObjectSpace,  // one dot product with the face plane per triangle, before any of its vertices is transformed,
+                // entities with a flattening scale or without face planes fall back to ScreenSpace
+  ScreenSpace,  // the winding of the projected triangle, after the vertex stage and clipping
+};
+
+struct RenderOptions {
+  FaceCulling face_culling = FaceCulling::ObjectSpace;
+  bool render_wireframe = false;
+  bool render_filled_triangle = true;
+  bool render_vertex_points = false;
+  bool render_textured = false;
+  // modulate texels with the light of their triangle like filled triangles are
+  bool render_lit_textures = false;
+  // clear each tile when it is first drawn to instead of the whole frame up front
+  bool enable_lazy_clear = true;
+  // upload and present a frame while the next one is rasterized, on the present thread for presenters that allow it,
+  // otherwise from the main thread while the job workers rasterize
+  bool enable_async_present = true;
+  // build the geometry of the next frame while the current one is rasterized, adds a frame of latency
+  bool enable_frame_pipelining = false;
+  ShadingMode shading_mode = ShadingMode::Forward;
+  SamplerState sampler{};
+};
+
+}  // namespace swr
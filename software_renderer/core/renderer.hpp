@@ -1,51 +1,164 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
 #include <chrono>
 #include <iostream>
+#include <memory>
 #include <numbers>
+#include <numeric>
+#include <ranges>
+#include <type_traits>
+#include <utility>
 
 #include <math/vector2.hpp>
 #include <math/transformation.hpp>
 #include <math/projection.hpp>
 
 #include "canvas.hpp"
-#include "context.hpp"
+#include "clipper.hpp"
 #include "entity.hpp"
+#include "face_culling.hpp"
+#include "frustum.hpp"
+#include "job_system.hpp"
 #include "pods.hpp"
+#include "present_thread.hpp"
+#include "presenter.hpp"
+#include "radix_sort.hpp"
+#include "render_options.hpp"
+#include "tile_binner.hpp"
 #include "utils.hpp"
 
 namespace swr {
 
-struct RenderOptions {
-  bool enable_back_face_culling = true;
-  bool render_wireframe = false;
-  bool render_filled_triangle = true;
-  bool render_vertex_points = false;
-  bool render_textured = false;
-};
-
 struct Triangle {
   bonfire::math::float2 points[3] = {};
   bonfire::math::float2 uvs[3] = {};
   bonfire::math::float3 normal = {};
   float avg_depth = 0.0f;
+  // depth buffer value of every corner, 0 at the near and 1 at the far plane
+  float depths[3] = {};
 };
 
 struct RenderData {
+  // face stage output, the triangles facing the camera per assembly chunk and whether each vertex is used by one,
+  // both empty when faces were not culled in object space
+  std::vector<std::vector<std::uint32_t>> visible_faces{};
+  std::vector<std::uint8_t> vertex_used{};
+  // back faces are left to the winding test on screen, set when they could not be culled in object space
+  bool cull_on_screen = false;
+  std::size_t transformed_vertices = 0;
+
+  // vertex stage output, one entry per vertex of the drawable so triangles sharing a vertex share its transform
+  std::vector<bonfire::math::float3> world_positions{};
+  std::vector<bonfire::math::float4> clip_positions{};
+  std::vector<bonfire::math::float2> screen_positions{};
+  // planes every vertex is outside of, see clip_code, left empty for entities entirely inside the frustum
+  std::vector<std::uint8_t> clip_codes{};
+  // where the entity was against the frustum, an entity outside of it has no vertices transformed and no triangles
+  FrustumTest visibility = FrustumTest::Intersecting;
+
   std::vector<Triangle> triangles{};
+  // triangles of the ranges of a large mesh, assembled in parallel before they are joined into triangles
+  std::vector<std::vector<Triangle>> triangle_chunks{};
   std::size_t texture_index = std::numeric_limits<std::size_t>::max();
 };
 
+// A triangle of the scene with what it is drawn with, indexed by the low half of draw order entries
+struct SceneTriangle {
+  const Triangle* triangle = nullptr;
+  const Texture* texture = nullptr;
+};
+
+// textures a frame can tell apart in its draw keys, slot 0 is shared by the untextured triangles
+inline constexpr std::uint32_t TEXTURE_SLOT_BITS = 10;
+inline constexpr std::uint32_t TEXTURE_SLOT_COUNT = 1u << TEXTURE_SLOT_BITS;
+
+/**
+ * Sort key of a triangle in the scene wide draw order. The painters algorithm of the forward path and the visibility
+ * buffer needs the farthest triangle first, the depth prepass rejects the most pixels with the nearest first. The
+ * depth decides, but its lowest TEXTURE_SLOT_BITS bits are replaced with the texture slot of the triangle: triangles
+ * whose depths differ by less than about 1 / 8192 of their depth are grouped by texture, so the rasterizer switches
+ * textures less often. Ties keep the order of the scene wide triangle index, which is entity by entity.
+ */
+[[nodiscard]] constexpr auto draw_key(const float depth, const std::uint32_t texture_slot, const ShadingMode mode) noexcept
+    -> std::uint32_t {
+  constexpr auto SLOT_MASK = TEXTURE_SLOT_COUNT - 1;
+  const auto key = mode == ShadingMode::DepthPrepass ? sortable_key(depth) : ~sortable_key(depth);
+  return (key & ~SLOT_MASK) | (texture_slot & SLOT_MASK);
+}
+
+// Geometry of one frame, the pipelined frame loop builds the next one while the current one is rasterized
+struct FrameGeometry {
+  // transforms of the entities when the frame was started, the geometry is built from these
+  std::vector<TransformComponent> transforms{};
+  std::vector<RenderData> render_datas{};
+
+  // every triangle of the scene, entity by entity, the first index of every entity in triangle_offsets
+  std::vector<SceneTriangle> triangles{};
+  std::vector<std::size_t> triangle_offsets{};
+  // draw key slot per texture index, see build_draw_order
+  std::vector<std::uint32_t> texture_slots{};
+  // sort entries of draw key and scene triangle index, in drawing order
+  std::vector<std::uint64_t> draw_order{};
+  // the draw order depends on the shading mode, the frame is rasterized with the one it was built for
+  ShadingMode shading_mode = ShadingMode::Forward;
+  RadixSorter sorter{};
+};
+
+struct DrawCommand;
+
+// Shade the textured surface of a command inside clip, or pixels [x0, x1) of row y of it, the sampler is baked in
+using TextureTriangleShader = auto (*)(Canvas& canvas, const DrawCommand& command, const Rect& clip) -> std::size_t;
+using TextureSpanShader = auto (*)(Canvas& canvas, const DrawCommand& command, int y, int x0, int x1) -> std::size_t;
+
+// A triangle ready for rasterization, the unit that gets binned into screen tiles
+struct DrawCommand {
+  const Triangle* triangle = nullptr;
+  const Texture* texture = nullptr;
+  std::uint32_t color = 0xFFFFFFFF;
+  // per channel light factor, color is white lit with it
+  std::uint32_t light = 0xFFFFFFFF;
+  // the triangle in the rasterizers fixed point, converted once rather than by every tile it overlaps
+  Vertex2 vertices[3] = {};
+  // depth over the screen, only set up for the depth prepass
+  AttributePlane depth{};
+  // texturing state, set up once per command rather than by every tile and resolved run that shades it
+  const Texture* mip = nullptr;
+  UvPlanes uv{};
+  TextureTriangleShader shade_texture_triangle = nullptr;
+  TextureSpanShader shade_texture_span = nullptr;
+};
+
+struct FrameStats {
+  // surface pixels written, a pixel drawn over by several triangles counts once per triangle. The depth only writes
+  // of a depth prepass shade nothing and do not count
+  std::size_t shaded_pixels = 0;
+  std::size_t frame_pixels = 0;
+  // vertices transformed and projected by the vertex stage
+  std::size_t transformed_vertices = 0;
+  // entities skipped because their bounds are outside the frustum, and those entirely inside of it
+  std::size_t culled_entities = 0;
+  std::size_t inside_entities = 0;
+
+  // 1.0 means every pixel of the frame was shaded once, overdraw pushes it up and uncovered pixels down
+  [[nodiscard]] auto shaded_per_pixel() const noexcept -> double {
+    return frame_pixels != 0 ? static_cast<double>(shaded_pixels) / static_cast<double>(frame_pixels) : 0.0;
+  }
+};
+
 class Renderer {
 public:
-  explicit Renderer(const int width, const int height) noexcept
-      : canvas_{width, height}, context_{}, entities_{}, camera_pos_{0.0f}, options_{}, is_running_{false}, light_{} {}
+  explicit Renderer(const int width, const int height, std::unique_ptr<Presenter> presenter) noexcept
+      : canvas_{width, height}, presenter_{std::move(presenter)}, entities_{}, camera_pos_{0.0f}, options_{}, is_running_{false}, light_{},
+        binner_{width, height}, tile_shaded_pixels_(binner_.tile_count(), 0), jobs_{},
+        present_thread_{[this](const ColorBuffer& frame) { presenter_->present(frame); }} {}
 
   [[nodiscard]] auto initialize() -> bool {
-    auto ctx = Context::create_context(canvas_.get_width(), canvas_.get_height());
-    if (ctx.has_value()) {
-      context_ = std::move(*ctx);
+    if (presenter_->initialize(canvas_.get_width(), canvas_.get_height())) {
+      is_initialized_ = true;
 
       const auto aspect = static_cast<float>(canvas_.get_width()) / static_cast<float>(canvas_.get_height());
 
@@ -56,6 +169,8 @@ public:
       constexpr float fov_radians = std::numbers::pi_v<float> / 3.0f; // 60 degrees
       projection_matrix_ = bonfire::math::make_projection(aspect, fov_radians, 0.1f, 100.0f, bonfire::math::coordinate_system::LeftHandedTag{},
                                                           bonfire::math::depth_range::NegativeOneToOneTag{});
+      // world positions go through the projection alone, so its planes are the frustum in world space
+      frustum_ = Frustum{projection_matrix_};
 
       // light direction towards z axis(inside the monitor)
       light_.direction = bonfire::math::float3{0.0f, 0.0f, 1.0f};
@@ -71,14 +186,32 @@ public:
   }
 
   void add_entity(Entity&& entity) {
-    RenderData rd {};
-    rd.triangles.reserve(entity.drawable.indices.size() / 3);
-    render_datas_.emplace_back(std::move(rd));
+    entity.drawable.bounds = bounding_sphere(entity.drawable.vertices);
+    entity.drawable.face_planes = face_planes(entity.drawable.vertices, entity.drawable.indices);
+
+    for (auto& frame : frames_) {
+      RenderData rd {};
+      rd.world_positions.reserve(entity.drawable.vertices.size());
+      rd.clip_positions.reserve(entity.drawable.vertices.size());
+      rd.screen_positions.reserve(entity.drawable.vertices.size());
+      rd.triangles.reserve(entity.drawable.indices.size() / 3);
+      frame.render_datas.emplace_back(std::move(rd));
+    }
     entities_.emplace_back(std::move(entity));
+    // the geometry built ahead does not have the new entity
+    next_frame_ready_ = false;
   }
 
+  [[nodiscard]] auto options() noexcept -> RenderOptions& { return options_; }
+
+  // Job system the frame stages run on, share it for asset loading instead of starting more threads
+  [[nodiscard]] auto jobs() noexcept -> JobSystem& { return jobs_; }
+
+  // Statistics of the last rendered frame
+  [[nodiscard]] auto stats() const noexcept -> const FrameStats& { return stats_; }
+
   void render_forever() {
-    if (!context_.window || !context_.renderer || !context_.color_buffer_texture) {
+    if (!is_initialized_) {
       std::cerr << "Make sure to call after successful initialize" << std::endl;
       return;
     }
@@ -88,7 +221,10 @@ public:
     auto current_time = std::chrono::high_resolution_clock::now();
 
     while (is_running_) [[likely]] {
-      process_input();
+      if (!presenter_->process_events(options_)) {
+        is_running_ = false;
+        break;
+      }
 
       auto new_time = std::chrono::high_resolution_clock::now();
       const auto delta_time = std::chrono::duration<float, std::chrono::seconds::period>(new_time - current_time).count();
@@ -99,166 +235,746 @@ public:
       render();
     }
 
-    context_.cleanup();
+    finish_presents();
+    presenter_->shutdown();
+  }
+
+  /**
+   * @brief Renders the given number of frames as fast as possible and returns the average frame time in
+   * milliseconds. Meant for headless presenters, input events are not processed.
+   */
+  auto render_frames(const std::size_t frame_count) -> double {
+    if (!is_initialized_ || frame_count == 0) {
+      return 0.0;
+    }
+
+    const auto start = std::chrono::high_resolution_clock::now();
+
+    for (std::size_t i = 0; i < frame_count; i++) {
+      update(0.0f);
+      render();
+    }
+    finish_presents();
+
+    const auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start);
+    return elapsed.count() / static_cast<double>(frame_count);
   }
 
 private:
-  void process_input() {
-    SDL_Event ev;
-    SDL_PollEvent(&ev);
+  /**
+   * Makes the frame just rasterized the front buffer and presents it. Presenting asynchronously overlaps it with
+   * rasterizing the next frame in one of two ways: presenters that allow it get the frame on the present thread,
+   * the others are left on the main thread and are handed the frame by the next rasterize_frame, which presents it
+   * while the workers rasterize. Either way the back buffer is only drawn into once its present has finished.
+   */
+  void present_frame() {
+    // the frame before must be on screen before its buffer can be drawn into again
+    present_thread_.wait_idle();
+    canvas_.swap_buffers();
+
+    if (!options_.enable_async_present) {
+      presenter_->present(canvas_.get_front_buffer());
+    } else if (presenter_->supports_async_present()) {
+      present_thread_.submit(canvas_.get_front_buffer());
+    } else {
+      front_buffer_pending_ = true;
+    }
+  }
 
-    switch (ev.type) {
-      case SDL_QUIT: {
-        std::cout << "SDL_QUIT" << std::endl;
-        is_running_ = false;
-        break;
+  // Presents the front buffer if it is still waiting for the main thread, see present_frame
+  void present_pending_frame() {
+    if (front_buffer_pending_) {
+      presenter_->present(canvas_.get_front_buffer());
+      front_buffer_pending_ = false;
+    }
+  }
+
+  // Blocks until every finished frame is on screen
+  void finish_presents() {
+    present_thread_.wait_idle();
+    present_pending_frame();
+  }
+
+  /**
+   * Renders a frame. With frame pipelining the geometry of the next frame is built on the job system while this one
+   * is rasterized, from a snapshot of the transforms taken now. Both stages can then keep the workers busy when
+   * neither can alone, at the cost of showing every update one frame later.
+   */
+  void render() {
+    auto& frame = frames_[current_frame_];
+
+    if (!options_.enable_frame_pipelining || !next_frame_ready_) {
+      snapshot_transforms(frame);
+      process_frame_geometry(frame);
+    }
+
+    JobSystem::JobHandle next_geometry;
+    if (options_.enable_frame_pipelining) {
+      auto& next_frame = frames_[1 - current_frame_];
+      snapshot_transforms(next_frame);
+      next_geometry = jobs_.schedule([this, &next_frame] { process_frame_geometry(next_frame); });
+    }
+
+    rasterize_frame(frame);
+
+    jobs_.wait(next_geometry);
+    if (next_geometry != nullptr) {
+      current_frame_ = 1 - current_frame_;
+    }
+    next_frame_ready_ = next_geometry != nullptr;
+  }
+
+  void snapshot_transforms(FrameGeometry& frame) const {
+    frame.transforms.resize(entities_.size());
+    for (std::size_t i = 0; i < entities_.size(); i++) {
+      frame.transforms[i] = entities_[i].transform;
+    }
+  }
+
+  void process_frame_geometry(FrameGeometry& frame) {
+    // entities are independent, each one only writes its own RenderData
+    jobs_.parallel_for(entities_.size(), [this, &frame](const std::size_t entity_idx) { process_geometry(frame, entity_idx); });
+
+    build_draw_order(frame);
+  }
+
+  void rasterize_frame(const FrameGeometry& frame) {
+    stats_.transformed_vertices = 0;
+    stats_.culled_entities = 0;
+    stats_.inside_entities = 0;
+    for (std::size_t entity_idx = 0; entity_idx < frame.render_datas.size(); entity_idx++) {
+      const auto visibility = frame.render_datas[entity_idx].visibility;
+      if (visibility == FrustumTest::Outside) {
+        stats_.culled_entities++;
+        continue;
       }
-      case SDL_KEYDOWN: {
-        if (ev.key.keysym.sym == SDLK_ESCAPE) {
-          std::cout << "SDLK_ESCAPE" << std::endl;
-          is_running_ = false;
-        } else if (ev.key.keysym.sym == SDLK_1) {
-          options_.render_filled_triangle = !options_.render_filled_triangle;
-        } else if (ev.key.keysym.sym == SDLK_2) {
-          options_.render_wireframe = !options_.render_wireframe;
-        } else if (ev.key.keysym.sym == SDLK_3) {
-          options_.enable_back_face_culling = !options_.enable_back_face_culling;
-        } else if (ev.key.keysym.sym == SDLK_4) {
-          options_.render_vertex_points = !options_.render_vertex_points;
-        } else if (ev.key.keysym.sym == SDLK_5) {
-          options_.render_textured = !options_.render_textured;
+      stats_.inside_entities += visibility == FrustumTest::Inside ? 1 : 0;
+      stats_.transformed_vertices += frame.render_datas[entity_idx].transformed_vertices;
+    }
+
+    bin_triangles(frame);
+
+    // the render options are fixed for the whole frame, so the rasterizer specialized for them is picked once here,
+    // for the shading mode the draw order was built for
+    const auto rasterize_bin = select_bin_rasterizer(frame.shading_mode);
+
+    // every tile is rasterized by exactly one worker and replays its bin in submission order,
+    // so the final image does not depend on the number of threads
+    const auto rasterize_tiles = [this, rasterize_bin] {
+      jobs_.parallel_for(binner_.tile_count(), [this, rasterize_bin](const std::size_t tile_index) {
+        tile_shaded_pixels_[tile_index] = rasterize_tile(tile_index, rasterize_bin);
+      });
+    };
+
+    if (front_buffer_pending_) {
+      // the last frame is presented from the front buffer while the workers rasterize this one into the back buffer,
+      // the main thread joins them once it is done
+      const auto tiles = jobs_.schedule(rasterize_tiles);
+      present_pending_frame();
+      jobs_.wait(tiles);
+    } else {
+      rasterize_tiles();
+    }
+
+    stats_.shaded_pixels = std::accumulate(tile_shaded_pixels_.begin(), tile_shaded_pixels_.end(), std::size_t{0});
+    stats_.frame_pixels = static_cast<std::size_t>(canvas_.get_width()) * static_cast<std::size_t>(canvas_.get_height());
+
+    // tiles nothing was drawn to still hold the previous frame
+    canvas_.resolve_clears();
+
+    present_frame();
+
+    if (options_.enable_lazy_clear) {
+      canvas_.clear_color_lazy(0xFF000000);
+    } else {
+      canvas_.clear_color(0xFF000000);
+    }
+  }
+
+  // vertices transformed and triangles assembled per job, large meshes are split into ranges of this size
+  static constexpr std::size_t VERTICES_PER_JOB = 4096;
+  static constexpr std::size_t TRIANGLES_PER_JOB = 4096;
+  static constexpr std::size_t COMMANDS_PER_JOB = 1024;
+
+  // Transforms, culls and projects the mesh of an entity into its RenderData of frame
+  void process_geometry(FrameGeometry& frame, const std::size_t entity_idx) {
+    namespace bm = bonfire::math;
+
+    auto& render_data = frame.render_datas[entity_idx];
+    const auto& drawable = entities_[entity_idx].drawable;
+    const auto& vertices = drawable.vertices;
+    const auto& transform = frame.transforms[entity_idx];
+
+    render_data.texture_index = entity_idx;
+
+    auto world_matrix = bm::make_world_matrix(transform.scale, transform.rotation, transform.position);
+
+    // entity stage, nothing of an entity whose bounds are outside the frustum is transformed
+    render_data.visibility = frustum_.classify(transform_bounds(drawable.bounds, world_matrix, transform.scale));
+    if (render_data.visibility == FrustumTest::Outside) {
+      render_data.triangles.clear();
+      render_data.transformed_vertices = 0;
+      return;
+    }
+
+    const auto& indices = drawable.indices;
+    const auto triangle_count = indices.size() / 3;
+    const auto chunk_count = std::max<std::size_t>(1, (triangle_count + TRIANGLES_PER_JOB - 1) / TRIANGLES_PER_JOB);
+
+    // face stage, the camera is taken into object space once and every triangle facing away from it is dropped
+    // with one dot product, before any of its vertices is transformed. A mirroring scale turns faces inside out.
+    // A flattening scale or a drawable without a plane per face falls back to the winding test on screen.
+    const auto scale_determinant = transform.scale.x * transform.scale.y * transform.scale.z;
+    const bool cull_in_object_space = options_.face_culling == FaceCulling::ObjectSpace && scale_determinant != 0.0f &&
+                                      drawable.face_planes.size() == triangle_count;
+    render_data.cull_on_screen = options_.face_culling != FaceCulling::None && !cull_in_object_space;
+
+    auto& visible_faces = render_data.visible_faces;
+    auto& vertex_used = render_data.vertex_used;
+    if (cull_in_object_space) {
+      const auto camera = (bm::make_inverse_world_matrix(transform.scale, transform.rotation, transform.position) *
+                           bm::float4(camera_pos_, 1.0f)).to_vec3();
+      const bool mirrored = scale_determinant < 0.0f;
+
+      visible_faces.resize(chunk_count);
+      vertex_used.assign(vertices.size(), 0);
+      jobs_.parallel_for(chunk_count, [&](const std::size_t chunk) {
+        auto& faces = visible_faces[chunk];
+        faces.clear();
+        const auto last = std::min(triangle_count, (chunk + 1) * TRIANGLES_PER_JOB);
+        for (auto face = chunk * TRIANGLES_PER_JOB; face < last; face++) {
+          if (faces_viewpoint(drawable.face_planes[face], camera) == mirrored) {
+            continue;
+          }
+          faces.push_back(static_cast<std::uint32_t>(face));
+          // chunks share vertices, every writer stores the same value
+          for (std::size_t k = 0; k < 3; k++) {
+            std::atomic_ref{vertex_used[indices[3 * face + k]]}.store(1, std::memory_order_relaxed);
+          }
         }
-        break;
+      });
+    } else {
+      visible_faces.clear();
+      vertex_used.clear();
+    }
+
+    // vertex stage, every unique vertex is transformed and projected once no matter how many triangles share it
+    auto& world_positions = render_data.world_positions;
+    auto& clip_positions = render_data.clip_positions;
+    auto& screen_positions = render_data.screen_positions;
+    auto& clip_codes = render_data.clip_codes;
+    world_positions.resize(vertices.size());
+    clip_positions.resize(vertices.size());
+    screen_positions.resize(vertices.size());
+    // the triangles of an entity inside the frustum cannot cross any plane
+    clip_codes.resize(render_data.visibility == FrustumTest::Inside ? 0 : vertices.size());
+    const bool needs_clipping = !clip_codes.empty();
+
+    // positions are read straight from their streams, uvs are only touched by the triangles that survive culling
+    const auto xs = vertices.x();
+    const auto ys = vertices.y();
+    const auto zs = vertices.z();
+    jobs_.parallel_for(vertices.size(), VERTICES_PER_JOB, [&](const std::size_t i) {
+      if (!vertex_used.empty() && vertex_used[i] == 0) {
+        return;
       }
-      default: {
-        break;
+      world_positions[i] = (world_matrix * bm::float4(xs[i], ys[i], zs[i], 1.0f)).to_vec3();
+      clip_positions[i] = projection_matrix_ * bm::float4(world_positions[i], 1.0f);
+      // the screen position of a vertex behind the camera is meaningless, but its triangles are all clipped
+      screen_positions[i] = to_screen(clip_positions[i]);
+      if (needs_clipping) {
+        clip_codes[i] = clip_code(clip_positions[i]);
+      }
+    });
+
+    render_data.transformed_vertices =
+        vertex_used.empty() ? vertices.size() : static_cast<std::size_t>(std::ranges::count(vertex_used, std::uint8_t{1}));
+
+    // triangle assembly, ranges of a large mesh are assembled into their own chunks and joined in index order,
+    // so the triangles come out in the same order however the work was split
+    render_data.triangles.clear();
+    if (chunk_count == 1) {
+      assemble_triangles(drawable, render_data, 0, render_data.triangles);
+    } else {
+      auto& chunks = render_data.triangle_chunks;
+      chunks.resize(chunk_count);
+      jobs_.parallel_for(chunk_count, [&](const std::size_t chunk) {
+        chunks[chunk].clear();
+        assemble_triangles(drawable, render_data, chunk, chunks[chunk]);
+      });
+
+      for (const auto& chunk : chunks) {
+        render_data.triangles.insert(render_data.triangles.end(), chunk.begin(), chunk.end());
+      }
+    }
+  }
+
+  /**
+   * Sorts the triangles of all entities into one draw order, so triangles of different entities are ordered by
+   * depth as well. Keys are built in parallel per entity, only the 8 byte entries are sorted.
+   */
+  void build_draw_order(FrameGeometry& frame) {
+    auto& offsets = frame.triangle_offsets;
+    offsets.resize(frame.render_datas.size());
+
+    std::size_t triangle_count = 0;
+    for (std::size_t entity_idx = 0; entity_idx < frame.render_datas.size(); entity_idx++) {
+      offsets[entity_idx] = triangle_count;
+      triangle_count += frame.render_datas[entity_idx].triangles.size();
+    }
+
+    frame.triangles.resize(triangle_count);
+    frame.draw_order.resize(triangle_count);
+    frame.shading_mode = options_.shading_mode;
+
+    // only the textures with triangles to draw get a slot, so they run out when more than TEXTURE_SLOT_COUNT - 1
+    // are visible at once. Release builds then share slots, which costs texture grouping but not correctness
+    auto& texture_slots = frame.texture_slots;
+    texture_slots.assign(entities_.size(), 0);
+    std::uint32_t next_slot = 1;
+    for (const auto& render_data : frame.render_datas) {
+      const auto texture_index = render_data.texture_index;
+      if (!render_data.triangles.empty() && texture_index != std::numeric_limits<std::size_t>::max() &&
+          texture_slots[texture_index] == 0) {
+        texture_slots[texture_index] = next_slot++;
+      }
+    }
+    assert(next_slot <= TEXTURE_SLOT_COUNT && "more textures visible than the draw key has slots for");
+
+    jobs_.parallel_for(frame.render_datas.size(), [&](const std::size_t entity_idx) {
+      const auto& render_data = frame.render_datas[entity_idx];
+
+      const Texture* texture = nullptr;
+      std::uint32_t texture_slot = 0;
+      if (render_data.texture_index != std::numeric_limits<std::size_t>::max()) {
+        texture = &entities_[render_data.texture_index].drawable.texture;
+        texture_slot = texture_slots[render_data.texture_index];
+      }
+
+      for (std::size_t i = 0; i < render_data.triangles.size(); i++) {
+        const auto& tri = render_data.triangles[i];
+        const auto index = offsets[entity_idx] + i;
+        frame.triangles[index] = SceneTriangle{&tri, texture};
+        frame.draw_order[index] = make_sort_entry(draw_key(tri.avg_depth, texture_slot, frame.shading_mode), static_cast<std::uint32_t>(index));
+      }
+    });
+
+    frame.sorter.sort(frame.draw_order, &jobs_);
+  }
+
+  // Appends the triangles of an assembly chunk that survive culling to out, clipped where they cross a plane
+  void assemble_triangles(const DrawableComponent& drawable, const RenderData& render_data, const std::size_t chunk,
+                          std::vector<Triangle>& out) const {
+    if (!render_data.visible_faces.empty()) {
+      for (const auto face : render_data.visible_faces[chunk]) {
+        assemble_triangle(drawable, render_data, face, out);
       }
+      return;
+    }
+
+    const auto last = std::min(drawable.indices.size() / 3, (chunk + 1) * TRIANGLES_PER_JOB);
+    for (auto face = chunk * TRIANGLES_PER_JOB; face < last; face++) {
+      assemble_triangle(drawable, render_data, face, out);
     }
   }
 
-  void copy_color_buffer() const {
-    SDL_UpdateTexture(context_.color_buffer_texture, nullptr, canvas_.get_color_buffer().data(), static_cast<int>(canvas_.get_width() * sizeof(std::uint32_t)));
-    SDL_RenderCopy(context_.renderer, context_.color_buffer_texture, nullptr, nullptr);
+  void assemble_triangle(const DrawableComponent& drawable, const RenderData& render_data, const std::size_t face,
+                         std::vector<Triangle>& out) const {
+    namespace bm = bonfire::math;
+
+    const auto& vertices = drawable.vertices;
+    const auto& indices = drawable.indices;
+    const auto& world_positions = render_data.world_positions;
+    const auto& clip_positions = render_data.clip_positions;
+    const auto& screen_positions = render_data.screen_positions;
+    const auto& clip_codes = render_data.clip_codes;
+
+    const auto idx0 = indices[3 * face];
+    const auto idx1 = indices[3 * face + 1];
+    const auto idx2 = indices[3 * face + 2];
+
+    std::uint8_t clip_planes = 0;
+    if (!clip_codes.empty()) {
+      // all three vertices outside of the same plane, nothing of the triangle is visible
+      if ((clip_codes[idx0] & clip_codes[idx1] & clip_codes[idx2]) != 0) {
+        return;
+      }
+      clip_planes = clip_codes[idx0] | clip_codes[idx1] | clip_codes[idx2];
+    }
+
+    const auto& pos0 = world_positions[idx0];
+    const auto& pos1 = world_positions[idx1];
+    const auto& pos2 = world_positions[idx2];
+
+    // back faces are gone already unless they are culled on screen, the normal is only needed for lighting
+    const auto normal_vec = bm::normalize(bm::cross_product(pos1 - pos0, pos2 - pos0));
+
+    Triangle triangle{
+      .points = { screen_positions[idx0], screen_positions[idx1], screen_positions[idx2] },
+      .uvs = {vertices.uv(idx0), vertices.uv(idx1), vertices.uv(idx2)},
+      .normal = normal_vec,
+      .avg_depth = (pos0.z + pos1.z + pos2.z) / 3.0f,
+      .depths = {screen_depth(clip_positions[idx0]), screen_depth(clip_positions[idx1]), screen_depth(clip_positions[idx2])}
+    };
+
+    const bool cull_on_screen = render_data.cull_on_screen;
+    const auto faces_camera = [](const Triangle& tri) {
+      return signed_area(tri.points[0], tri.points[1], tri.points[2]) >= 0.0f;
+    };
+
+    if (clip_planes == 0) {
+      if (!cull_on_screen || faces_camera(triangle)) {
+        out.push_back(triangle);
+      }
+      return;
+    }
+
+    ClipPolygon polygon{};
+    if (!clip_triangle(ClipVertex{clip_positions[idx0], triangle.uvs[0]}, ClipVertex{clip_positions[idx1], triangle.uvs[1]},
+                       ClipVertex{clip_positions[idx2], triangle.uvs[2]}, clip_planes, polygon)) {
+      return;
+    }
+
+    // the pieces keep the normal and average depth of the whole triangle, so they are lit and sorted like it. Only
+    // their screen positions are meaningful, so screen space culling looks at them instead of the original triangle
+    for (std::size_t k = 1; k + 1 < polygon.size; k++) {
+      const std::size_t corners[3] = {0, k, k + 1};
+      for (std::size_t corner = 0; corner < 3; corner++) {
+        const auto& vertex = polygon.vertices[corners[corner]];
+        triangle.points[corner] = to_screen(vertex.position);
+        triangle.uvs[corner] = vertex.uv;
+        triangle.depths[corner] = screen_depth(vertex.position);
+      }
+      if (!cull_on_screen || faces_camera(triangle)) {
+        out.push_back(triangle);
+      }
+    }
   }
 
-  void render() {
+  void bin_triangles(const FrameGeometry& frame) {
     namespace bm = bonfire::math;
 
-    for (std::size_t entity_idx = 0; entity_idx < entities_.size(); entity_idx++) {
-      auto& render_data = render_datas_[entity_idx];
+    draw_commands_.clear();
+    binner_.clear();
+
+    for (const auto entry : frame.draw_order) {
+      const auto& [triangle, texture] = frame.triangles[sort_entry_index(entry)];
+      const auto& tri = *triangle;
+
+      // calculate light based on how aligned is the face normal and the light direction
+      const float light_intensity_factor = -bm::dot_product(tri.normal, light_.direction) * 0.5f;
+
+      const auto command_index = static_cast<std::uint32_t>(draw_commands_.size());
+      const auto light = light_factor(light_intensity_factor);
+      draw_commands_.push_back(DrawCommand{&tri, texture, simd::modulate_color(0xFFFFFFFF, light), light,
+                                           {Vertex2{tri.points[0], tri.uvs[0]}, Vertex2{tri.points[1], tri.uvs[1]},
+                                            Vertex2{tri.points[2], tri.uvs[2]}}});
+
+      // rasterizers work on truncated integer positions, vertex points extend 3 pixels to the right and bottom
+      Rect bounds{std::numeric_limits<int>::max(), std::numeric_limits<int>::max(), std::numeric_limits<int>::min(),
+                  std::numeric_limits<int>::min()};
+      for (const auto& point : tri.points) {
+        const auto x = static_cast<int>(point.x);
+        const auto y = static_cast<int>(point.y);
+        bounds.min_x = std::min(bounds.min_x, x - 1);
+        bounds.min_y = std::min(bounds.min_y, y - 1);
+        bounds.max_x = std::max(bounds.max_x, x + 4);
+        bounds.max_y = std::max(bounds.max_y, y + 4);
+      }
 
-      render_data.texture_index = entity_idx;
+      binner_.bin(command_index, bounds);
+    }
 
-      render_data.triangles.clear();
+    const bool depth_tested = frame.shading_mode == ShadingMode::DepthPrepass;
+    if (options_.render_textured || depth_tested) {
+      jobs_.parallel_for(draw_commands_.size(), COMMANDS_PER_JOB, [this, depth_tested](const std::size_t command_index) {
+        auto& command = draw_commands_[command_index];
+        if (depth_tested) {
+          const auto& [v0, v1, v2] = command.vertices;
+          const auto& depths = command.triangle->depths;
+          command.depth = attribute_plane(v0, v1, v2, depths[0], depths[1], depths[2]);
+        }
+        if (options_.render_textured) {
+          prepare_texturing(command, depth_tested);
+        }
+      });
+    }
+  }
 
-      const auto& vertices = entities_[entity_idx].drawable.vertices;
-      const auto& indices = entities_[entity_idx].drawable.indices;
-      const auto& transform = entities_[entity_idx].transform;
+  // Picks the mip level, uv planes and shaders of a textured command, see with_texture_shader. The triangle shader
+  // of the depth prepass only shades the pixels at the depth its first pass left
+  void prepare_texturing(DrawCommand& command, const bool depth_tested) const {
+    if (command.texture == nullptr) {
+      return;
+    }
 
-      auto world_matrix = bm::make_world_matrix(transform.scale, transform.rotation, transform.position);
+    const auto& [v0, v1, v2] = command.vertices;
+    command.mip = &select_mip(v0, v1, v2, *command.texture);
+    command.uv = uv_planes(v0, v1, v2);
 
-      for (std::size_t i = 0; i < indices.size();) {
+    with_sampler(*command.mip, options_.sampler, [&](const auto& sample) {
+      using Sampler = std::remove_cvref_t<decltype(sample)>;
+      if (options_.render_lit_textures) {
+        set_texture_shaders<Sampler, true>(command, depth_tested);
+      } else {
+        set_texture_shaders<Sampler, false>(command, depth_tested);
+      }
+    });
+  }
 
-        const auto idx0 = indices[i++];
-        const auto idx1 = indices[i++];
-        const auto idx2 = indices[i++];
+  template <typename Sampler, bool Lit>
+  static void set_texture_shaders(DrawCommand& command, const bool depth_tested) noexcept {
+    command.shade_texture_triangle = depth_tested ? &shade_texture_triangle<Sampler, Lit, DepthEqual>
+                                                  : &shade_texture_triangle<Sampler, Lit, AlwaysPass>;
+    command.shade_texture_span = &shade_texture_span<Sampler, Lit>;
+  }
 
-        auto vertex0 = vertices[idx0];
-        auto vertex1 = vertices[idx1];
-        auto vertex2 = vertices[idx2];
+  // Calls fn with the pixel pipeline of the textured surface of command, lit by its light if Lit
+  template <typename Sampler, bool Lit, DepthTest Depth, typename Fn>
+  static auto with_texture_pipeline(const DrawCommand& command, Fn&& fn) -> std::size_t {
+    const TextureShader<Sampler> shader{Sampler{*command.mip}, command.uv};
+    const auto depth = [&] {
+      if constexpr (std::same_as<Depth, DepthEqual>) {
+        return DepthEqual{command.depth};
+      } else {
+        return Depth{};
+      }
+    }();
 
-        // transform vertices
-        vertex0.pos = (world_matrix * bm::float4(vertex0.pos, 1.0f)).to_vec3();
-        vertex1.pos = (world_matrix * bm::float4(vertex1.pos, 1.0f)).to_vec3();
-        vertex2.pos = (world_matrix * bm::float4(vertex2.pos, 1.0f)).to_vec3();
+    if constexpr (Lit) {
+      using Shader = LitShader<TextureShader<Sampler>>;
+      return fn(PixelPipeline<Shader, Depth>{Shader{shader, command.light}, depth});
+    } else {
+      return fn(PixelPipeline<TextureShader<Sampler>, Depth>{shader, depth});
+    }
+  }
 
-        /*
-         *  back face culling
-         *
-         *  Find vectors v1 - v0 and v2 - v0
-         *  Take their cross product and lets call it normal_vec
-         *  Find the camera ray by substracting the camera position from v0
-         *  Take the dot product between N and camera ray
-         *  if dot product is less than 0, return false
-         */
+  template <typename Sampler, bool Lit, DepthTest Depth>
+  static auto shade_texture_triangle(Canvas& canvas, const DrawCommand& command, const Rect& clip) -> std::size_t {
+    const auto& [v0, v1, v2] = command.vertices;
+    return with_texture_pipeline<Sampler, Lit, Depth>(
+        command, [&](const auto& pipeline) { return canvas.rasterize_triangle(v0, v1, v2, pipeline, clip); });
+  }
 
-        const auto vec_ab = bm::normalize(vertex1.pos - vertex0.pos);
-        const auto vec_ac = bm::normalize(vertex2.pos - vertex0.pos);
+  template <typename Sampler, bool Lit>
+  static auto shade_texture_span(Canvas& canvas, const DrawCommand& command, const int y, const int x0, const int x1)
+      -> std::size_t {
+    return with_texture_pipeline<Sampler, Lit, AlwaysPass>(
+        command, [&](const auto& pipeline) { return canvas.rasterize_span(y, x0, x1, pipeline); });
+  }
 
-        const auto normal_vec = bm::normalize(bm::cross_product(vec_ab, vec_ac));
+  using BinRasterizer = auto (Renderer::*)(const std::vector<std::uint32_t>& bin, const Rect& tile) -> std::size_t;
 
-        const auto camera_ray = camera_pos_ - vertex0.pos;
+  /*
+   * Every combination of shading mode and the filled, textured, wireframe and vertex point switches has its own
+   * instantiation of rasterize_bin, with the pixel pipelines of its surfaces and overlays known at compile time.
+   * The table is indexed by the options packed into bits, shading mode highest. Textured surfaces go through the
+   * shaders prepare_texturing picked per command, lighting them is part of that choice.
+   */
 
-        const auto dp = bm::dot_product(normal_vec, camera_ray);
+  static constexpr std::size_t BIN_RASTERIZER_COUNT = 3 * 16;
+
+  template <std::size_t Index>
+  static constexpr auto bin_rasterizer() noexcept -> BinRasterizer {
+    return &Renderer::rasterize_bin<static_cast<ShadingMode>(Index / 16), (Index & 8) != 0, (Index & 4) != 0,
+                                    (Index & 2) != 0, (Index & 1) != 0>;
+  }
 
-        if (options_.enable_back_face_culling && dp < 0.0f) {
-          continue;
+  [[nodiscard]] auto select_bin_rasterizer(const ShadingMode mode) const noexcept -> BinRasterizer {
+    static constexpr auto TABLE = []<std::size_t... Indices>(std::index_sequence<Indices...>) {
+      return std::array<BinRasterizer, BIN_RASTERIZER_COUNT>{bin_rasterizer<Indices>()...};
+    }(std::make_index_sequence<BIN_RASTERIZER_COUNT>{});
+
+    const auto index = static_cast<std::size_t>(mode) * 16 + (options_.render_filled_triangle ? 8 : 0) +
+                       (options_.render_textured ? 4 : 0) + (options_.render_wireframe ? 2 : 0) +
+                       (options_.render_vertex_points ? 1 : 0);
+    return TABLE[index];
+  }
+
+  // Returns the number of surface pixels shaded
+  auto rasterize_tile(const std::size_t tile_index, const BinRasterizer rasterize_bin) -> std::size_t {
+    const auto& bin = binner_.tile_bin(tile_index);
+    if (bin.empty()) {
+      return 0;
+    }
+
+    const auto tile = binner_.tile_rect(tile_index);
+
+    canvas_.prepare_tile(tile);
+
+    return (this->*rasterize_bin)(bin, tile);
+  }
+
+  /*
+   * The visibility buffer records, per pixel, the id of the surface drawn there last.
+   * The id is the index of the command shifted left by one, with the low bit telling the filled from the textured
+   * surface of the command. Commands are replayed in submission order, so ids grow in drawing order and act as the
+   * depth of the painters algorithm: a plain overwrite leaves the visible surface in the id buffer. Resolving it
+   * produces the image the forward path does, only overdrawn pixels are never shaded.
+   *
+   * The textured surface of a triangle covers exactly the pixels of the filled one and is drawn after it, so a
+   * command with a texture only ever draws its textured surface.
+   */
+
+  [[nodiscard]] static constexpr auto surface_id(const std::uint32_t command_index, const bool textured) noexcept -> std::uint32_t {
+    return (command_index << 1) | (textured ? 1u : 0u);
+  }
+
+  // Whether the command draws its textured surface, its filled surface or neither
+  template <bool Textured>
+  [[nodiscard]] static constexpr auto draws_textured(const DrawCommand& command) noexcept -> bool {
+    return Textured && command.texture != nullptr;
+  }
+
+  template <bool Filled, bool Textured>
+  [[nodiscard]] static constexpr auto draws_surface(const DrawCommand& command) noexcept -> bool {
+    return Filled || draws_textured<Textured>(command);
+  }
+
+  template <ShadingMode Mode, bool Filled, bool Textured, bool Wireframe, bool Points>
+  auto rasterize_bin(const std::vector<std::uint32_t>& bin, const Rect& tile) -> std::size_t {
+    if constexpr (Mode == ShadingMode::VisibilityBuffer) {
+      return rasterize_bin_visibility_buffer<Filled, Textured, Wireframe, Points>(bin, tile);
+    } else if constexpr (Mode == ShadingMode::DepthPrepass) {
+      return rasterize_bin_depth_prepass<Filled, Textured, Wireframe, Points>(bin, tile);
+    } else {
+      std::size_t shaded = 0;
+      for (const auto command_index : bin) {
+        const auto& command = draw_commands_[command_index];
+        const auto& [v0, v1, v2] = command.vertices;
+        const bool textured = draws_textured<Textured>(command);
+
+        if constexpr (Textured) {
+          if (textured) {
+            shaded += command.shade_texture_triangle(canvas_, command, tile);
+          }
         }
 
-        // project vertices
-        const auto projected_vertex0 = project(vertex0.pos);
-        const auto projected_vertex1 = project(vertex1.pos);
-        const auto projected_vertex2 = project(vertex2.pos);
-
-        render_data.triangles.push_back(
-          Triangle{
-            .points = { projected_vertex0, projected_vertex1, projected_vertex2 },
-            .uvs = {vertex0.uv, vertex1.uv, vertex2.uv},
-            .normal = normal_vec,
-            .avg_depth = (vertex0.pos.z + vertex1.pos.z + vertex2.pos.z) / 3.0f
+        if constexpr (Filled) {
+          if (!textured) {
+            shaded += canvas_.rasterize_triangle(v0, v1, v2, PixelPipeline<FlatShader>{FlatShader{command.color}}, tile);
           }
-        );
+        }
+
+        draw_overlays<Wireframe, Points>(command, tile, Canvas::Unmasked{});
       }
 
-      // sort the triangles by avg depth for painters algo, but a hacky way. Sometimes might not work
-      std::ranges::sort(render_data.triangles, [](const Triangle& lhs, const Triangle& rhs) {
-        return lhs.avg_depth < rhs.avg_depth;
-      });
+      return shaded;
+    }
+  }
+
+  template <bool Filled, bool Textured>
+  void record_surface_ids(const std::vector<std::uint32_t>& bin, const Rect& tile) {
+    canvas_.clear_ids(tile);
+
+    for (const auto command_index : bin) {
+      const auto& command = draw_commands_[command_index];
+      if (draws_surface<Filled, Textured>(command)) {
+        const auto& [v0, v1, v2] = command.vertices;
+        canvas_.draw_triangle_id(v0, v1, v2, surface_id(command_index, draws_textured<Textured>(command)), tile);
+      }
     }
+  }
 
-    for (const auto& [triangles, texture_index] : render_datas_) {
+  // Records the surface ids of the tile, then shades every run of equal ids in one go. Textured runs go through the
+  // span shader prepare_texturing picked for their command, with its sampler and lighting baked in
+  template <bool Filled, bool Textured, bool Wireframe, bool Points>
+  auto rasterize_bin_visibility_buffer(const std::vector<std::uint32_t>& bin, const Rect& tile) -> std::size_t {
+    record_surface_ids<Filled, Textured>(bin, tile);
 
-      for (const auto& tri : triangles) {
-        if (options_.render_filled_triangle) {
-          std::uint32_t color = 0xFFFFFFFF;
+    std::size_t shaded = 0;
+    canvas_.resolve_ids(tile, [&](const std::uint32_t id, const int y, const int x0, const int x1) {
+      const auto& command = draw_commands_[id >> 1];
 
-          // calculate light based on how aligned is the face normal and the light direction
-          const float light_intensity_factor = -bm::dot_product(tri.normal, light_.direction) * 0.5f;
-          color = light_apply_intensity(color, light_intensity_factor);
+      if ((id & 1) == 0) {
+        shaded += canvas_.rasterize_span(y, x0, x1, PixelPipeline<FlatShader>{FlatShader{command.color}});
+        return;
+      }
 
-          canvas_.draw_filled_triangle(tri.points[0].x, tri.points[0].y, tri.points[1].x, tri.points[1].y, tri.points[2].x, tri.points[2].y, color);
-        }
+      shaded += command.shade_texture_span(canvas_, command, y, x0, x1);
+    });
 
-        if (options_.render_textured && texture_index != std::numeric_limits<std::size_t>::max()) {
-          const Vertex2 v0{tri.points[0], tri.uvs[0]};
-          const Vertex2 v1{tri.points[1], tri.uvs[1]};
-          const Vertex2 v2{tri.points[2], tri.uvs[2]};
-          canvas_.draw_textured_triangle(v0, v1, v2, entities_[texture_index].drawable.texture);
-        }
+    // lines and points are not part of the visibility buffer. They are drawn in order after the resolve, each only
+    // where no surface of a later command was recorded, so later surfaces cover them as in the forward path
+    if constexpr (Wireframe || Points) {
+      for (const auto command_index : bin) {
+        draw_overlays<Wireframe, Points>(draw_commands_[command_index], tile, canvas_.id_mask(surface_id(command_index, true)));
+      }
+    }
 
-        if (options_.render_wireframe) {
-          // wireframe
-          canvas_.draw_triangle(tri.points[0].x, tri.points[0].y, tri.points[1].x, tri.points[1].y, tri.points[2].x, tri.points[2].y, 0xFFFFFFFF);
-        }
+    return shaded;
+  }
+
+  /*
+   * The depth prepass draws the bin twice, nearest triangles first. The first pass only writes depth: textured
+   * surfaces through the depth only span loop, filled surfaces depth tested together with their flat color, which
+   * is all there is to shading them. The second pass rasterizes the textured surfaces again through the DepthEqual
+   * test, so the texture is only sampled for the pixels a surface is visible at. Visibility is resolved per pixel
+   * rather than by the painters algorithm, triangles that intersect or are sorted wrong come out right.
+   */
+
+  template <bool Filled, bool Textured, bool Wireframe, bool Points>
+  auto rasterize_bin_depth_prepass(const std::vector<std::uint32_t>& bin, const Rect& tile) -> std::size_t {
+    canvas_.clear_depth(tile);
+
+    std::size_t shaded = 0;
+    for (const auto command_index : bin) {
+      const auto& command = draw_commands_[command_index];
+      const auto& [v0, v1, v2] = command.vertices;
+
+      if (draws_textured<Textured>(command)) {
+        canvas_.draw_triangle_depth(v0, v1, v2, command.depth, tile);
+      } else if (Filled) {
+        shaded += canvas_.draw_filled_triangle_depth(v0, v1, v2, command.depth, command.color, tile);
+      }
+    }
 
-        if (options_.render_vertex_points) {
-          canvas_.draw_rectangle(tri.points[0].x, tri.points[0].y, 3, 3, 0xFFFF0000);
-          canvas_.draw_rectangle(tri.points[1].x, tri.points[1].y, 3, 3, 0xFFFF0000);
-          canvas_.draw_rectangle(tri.points[2].x, tri.points[2].y, 3, 3, 0xFFFF0000);
+    if constexpr (Textured) {
+      for (const auto command_index : bin) {
+        const auto& command = draw_commands_[command_index];
+        if (draws_textured<Textured>(command)) {
+          shaded += command.shade_texture_triangle(canvas_, command, tile);
         }
       }
     }
 
-    copy_color_buffer();
-    SDL_RenderPresent(context_.renderer);
+    // lines and points have no depth of their own, they are drawn where the plane of their triangle is visible and
+    // farthest first like the other modes do. Vertex points reach past their triangle, so they can come out different
+    if constexpr (Wireframe || Points) {
+      for (const auto command_index : bin | std::views::reverse) {
+        const auto& command = draw_commands_[command_index];
+        draw_overlays<Wireframe, Points>(command, tile, canvas_.depth_mask(command.depth));
+      }
+    }
 
-    canvas_.clear_color(0xFF000000);
+    return shaded;
   }
 
-  [[nodiscard]] auto project(const bonfire::math::float3& vertex) const noexcept -> bonfire::math::float2 {
+  template <bool Wireframe, bool Points, typename Mask>
+  void draw_overlays(const DrawCommand& command, const Rect& tile, const Mask& mask) {
+    const auto& tri = *command.triangle;
+
+    if constexpr (Wireframe) {
+      canvas_.draw_triangle(tri.points[0].x, tri.points[0].y, tri.points[1].x, tri.points[1].y, tri.points[2].x, tri.points[2].y, 0xFFFFFFFF, tile, mask);
+    }
+
+    if constexpr (Points) {
+      canvas_.draw_rectangle(tri.points[0].x, tri.points[0].y, 3, 3, 0xFFFF0000, tile, mask);
+      canvas_.draw_rectangle(tri.points[1].x, tri.points[1].y, 3, 3, 0xFFFF0000, tile, mask);
+      canvas_.draw_rectangle(tri.points[2].x, tri.points[2].y, 3, 3, 0xFFFF0000, tile, mask);
+    }
+  }
+
+  // Depth buffer value of a clip space position, see Triangle::depths
+  [[nodiscard]] static auto screen_depth(const bonfire::math::float4& clip_position) noexcept -> float {
+    return 0.5f * (clip_position.w != 0.0f ? clip_position.z / clip_position.w : clip_position.z) + 0.5f;
+  }
+
+  // Screen position of a clip space position
+  [[nodiscard]] auto to_screen(const bonfire::math::float4& clip_position) const noexcept -> bonfire::math::float2 {
     namespace bm = bonfire::math;
 
-    auto projected_vertex = projection_matrix_ * bm::float4(vertex, 1.0f);
+    auto projected_vertex = clip_position;
 
     // perspective divide
     if (projected_vertex.w != 0.0f) {
@@ -291,15 +1007,30 @@ private:
 
 private:
   Canvas canvas_;
-  Context context_;
+  std::unique_ptr<Presenter> presenter_;
   std::vector<Entity> entities_;
-  std::vector<RenderData> render_datas_;
+  // geometry of the frame being rasterized and, with frame pipelining, of the one after it
+  std::array<FrameGeometry, 2> frames_{};
+  std::size_t current_frame_ = 0;
+  bool next_frame_ready_ = false;
   bonfire::math::float3 camera_pos_;
   bonfire::math::Mat4 projection_matrix_;
+  Frustum frustum_{};
   RenderOptions options_;
   bool is_running_;
+  bool is_initialized_ = false;
 
   Light light_;
+
+  std::vector<DrawCommand> draw_commands_{};
+  TileBinner binner_;
+  // surface pixels shaded per tile, every tile writes its own entry
+  std::vector<std::size_t> tile_shaded_pixels_;
+  FrameStats stats_{};
+  JobSystem jobs_;
+  PresentThread present_thread_;
+  // the front buffer waits for the main thread to present it while the next frame is rasterized, see present_frame
+  bool front_buffer_pending_ = false;
 };
 
 } // namespace swr
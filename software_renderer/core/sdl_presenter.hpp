@@ -0,0 +1,85 @@
+#pragma once
+
+#include <iostream>
+
+#include "context.hpp"
+#include "presenter.hpp"
+#include "sdl.hpp"
+
+namespace swr {
+
+// Presents frames in an SDL window and maps keyboard input to render options
+class SdlPresenter final : public Presenter {
+ public:
+  [[nodiscard]] auto initialize(const int width, const int height) -> bool override {
+    auto ctx = Context::create_context(width, height);
+    if (!ctx.has_value()) {
+      return false;
+    }
+
+    context_ = std::move(*ctx);
+    width_ = width;
+    return true;
+  }
+
+  [[nodiscard]] auto process_events(RenderOptions& options) -> bool override {
+    SDL_Event ev;
+
+    while (SDL_PollEvent(&ev)) {
+      switch (ev.type) {
+        case SDL_QUIT: {
+          std::cout << "SDL_QUIT" << std::endl;
+          return false;
+        }
+        case SDL_KEYDOWN: {
+          if (ev.key.keysym.sym == SDLK_ESCAPE) {
+            std::cout << "SDLK_ESCAPE" << std::endl;
+            return false;
+          } else if (ev.key.keysym.sym == SDLK_1) {
+            options.render_filled_triangle = !options.render_filled_triangle;
+          } else if (ev.key.keysym.sym == SDLK_2) {
+            options.render_wireframe = !options.render_wireframe;
+          } else if (ev.key.keysym.sym == SDLK_3) {
+            options.face_culling = static_cast<FaceCulling>((static_cast<int>(options.face_culling) + 1) % 3);
+          } else if (ev.key.keysym.sym == SDLK_4) {
+            options.render_vertex_points = !options.render_vertex_points;
+          } else if (ev.key.keysym.sym == SDLK_5) {
+            options.render_textured = !options.render_textured;
+          } else if (ev.key.keysym.sym == SDLK_6) {
+            options.sampler.filter = options.sampler.filter == TextureFilter::Nearest ? TextureFilter::Bilinear : TextureFilter::Nearest;
+          } else if (ev.key.keysym.sym == SDLK_7) {
+            options.sampler.wrap = static_cast<TextureWrap>((static_cast<int>(options.sampler.wrap) + 1) % 3);
+          } else if (ev.key.keysym.sym == SDLK_8) {
+            options.shading_mode = static_cast<ShadingMode>((static_cast<int>(options.shading_mode) + 1) % 3);
+          } else if (ev.key.keysym.sym == SDLK_9) {
+            options.render_lit_textures = !options.render_lit_textures;
+          } else if (ev.key.keysym.sym == SDLK_0) {
+            options.enable_frame_pipelining = !options.enable_frame_pipelining;
+          }
+          break;
+        }
+        default: {
+          break;
+        }
+      }
+    }
+
+    return true;
+  }
+
+  // SDL render calls must stay on the thread that created the renderer and polls events, so frames are presented
+  // from the main thread while the job workers rasterize the next one (see supports_async_present)
+  void present(const ColorBuffer& frame) override {
+    SDL_UpdateTexture(context_.color_buffer_texture, nullptr, frame.data(), static_cast<int>(width_ * sizeof(std::uint32_t)));
+    SDL_RenderCopy(context_.renderer, context_.color_buffer_texture, nullptr, nullptr);
+    SDL_RenderPresent(context_.renderer);
+  }
+
+  void shutdown() override { context_.cleanup(); }
+
+ private:
+  Context context_{};
+  int width_ = 0;
+};
+
+}  // namespace swr
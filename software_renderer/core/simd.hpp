@@ -0,0 +1,340 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SWR_HAS_SSE2 1
+#include <emmintrin.h>
+#else
+#define SWR_HAS_SSE2 0
+#endif
+
+#if defined(__AVX2__)
+#define SWR_HAS_AVX2 1
+#include <immintrin.h>
+#else
+#define SWR_HAS_AVX2 0
+#endif
+
+#if defined(__AVX512BW__)
+#define SWR_HAS_AVX512BW 1
+#include <immintrin.h>
+#else
+#define SWR_HAS_AVX512BW 0
+#endif
+
+namespace swr::simd {
+
+/**
+ * @brief Fills count 32 bit values starting at dst with non-temporal stores.
+ *
+ * Streaming stores bypass the cache, which is what we want for buffers that are much larger than the cache
+ * and will not be read back before they are evicted anyway (full frame clears).
+ */
+template <typename T>
+inline void stream_fill(T* dst, std::size_t count, const T value) noexcept {
+  static_assert(sizeof(T) == sizeof(std::uint32_t), "stream_fill works on 32 bit values");
+
+#if SWR_HAS_SSE2
+  // scalar head until dst is 16 byte aligned
+  while (count > 0 && reinterpret_cast<std::uintptr_t>(dst) % 16 != 0) {
+    *dst++ = value;
+    count--;
+  }
+
+  const auto v = _mm_set1_epi32(std::bit_cast<int>(value));
+  auto* out = reinterpret_cast<__m128i*>(dst);
+
+  for (; count >= 16; count -= 16) {
+    _mm_stream_si128(out + 0, v);
+    _mm_stream_si128(out + 1, v);
+    _mm_stream_si128(out + 2, v);
+    _mm_stream_si128(out + 3, v);
+    out += 4;
+  }
+
+  // make the streaming stores visible before anyone else touches the buffer
+  _mm_sfence();
+
+  dst = reinterpret_cast<T*>(out);
+#endif
+
+  std::fill_n(dst, count, value);
+}
+
+/*
+ * Depth tested spans
+ *
+ * The depth of pixel i of a span is (first + i) * dz + z0, first is the offset of the span start from where z0 is
+ * defined, so clipped spans produce bit exact depths. Pixels whose depth is smaller than the stored one pass.
+ */
+
+/**
+ * @brief Depth tested fill of count pixels, passing pixels get value and their new depth. Returns how many passed.
+ */
+inline auto fill_depth_tested(std::uint32_t* color, float* depth, const int count, const int first, const float z0,
+                              const float dz, const std::uint32_t value) noexcept -> std::size_t {
+  std::size_t written = 0;
+  int i = 0;
+
+#if SWR_HAS_SSE2
+  const auto v = _mm_set1_epi32(std::bit_cast<int>(value));
+  const auto base = _mm_set1_ps(z0);
+  const auto step = _mm_set1_ps(dz);
+  const auto four = _mm_set1_ps(4.0f);
+  auto index = _mm_add_ps(_mm_set1_ps(static_cast<float>(first)), _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f));
+
+  for (; i + 4 <= count; i += 4) {
+    const auto z = _mm_add_ps(_mm_mul_ps(index, step), base);
+    const auto stored_z = _mm_loadu_ps(depth + i);
+    const auto pass = _mm_cmplt_ps(z, stored_z);
+    _mm_storeu_ps(depth + i, _mm_or_ps(_mm_and_ps(pass, z), _mm_andnot_ps(pass, stored_z)));
+
+    auto* out = reinterpret_cast<__m128i*>(color + i);
+    const auto mask = _mm_castps_si128(pass);
+    _mm_storeu_si128(out, _mm_or_si128(_mm_and_si128(mask, v), _mm_andnot_si128(mask, _mm_loadu_si128(out))));
+
+    written += static_cast<std::size_t>(std::popcount(static_cast<unsigned>(_mm_movemask_ps(pass))));
+    index = _mm_add_ps(index, four);
+  }
+#endif
+
+  for (; i < count; i++) {
+    const auto z = static_cast<float>(first + i) * dz + z0;
+    if (z < depth[i]) {
+      depth[i] = z;
+      color[i] = value;
+      written++;
+    }
+  }
+
+  return written;
+}
+
+/**
+ * @brief Depth only counterpart of fill_depth_tested, the innermost loop of a depth prepass. Keeping the smaller
+ * depth is the depth test, so it comes down to one min per pixel and no color is touched.
+ */
+inline void write_depth_tested(float* depth, const int count, const int first, const float z0, const float dz) noexcept {
+  int i = 0;
+
+#if SWR_HAS_SSE2
+  const auto base = _mm_set1_ps(z0);
+  const auto step = _mm_set1_ps(dz);
+  const auto four = _mm_set1_ps(4.0f);
+  auto index = _mm_add_ps(_mm_set1_ps(static_cast<float>(first)), _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f));
+
+  for (; i + 4 <= count; i += 4) {
+    const auto z = _mm_add_ps(_mm_mul_ps(index, step), base);
+    // min returns its second operand unless the first is smaller, the same test as fill_depth_tested
+    _mm_storeu_ps(depth + i, _mm_min_ps(z, _mm_loadu_ps(depth + i)));
+    index = _mm_add_ps(index, four);
+  }
+#endif
+
+  for (; i < count; i++) {
+    const auto z = static_cast<float>(first + i) * dz + z0;
+    if (z < depth[i]) {
+      depth[i] = z;
+    }
+  }
+}
+
+/*
+ * Packed color kernels
+ *
+ * Colors are packed 8 bit channels and are combined per channel in fixed point, the vector paths widen the
+ * channels to 16 bit lanes and handle 16 (AVX-512), 8 (AVX2) or 4 (SSE2) colors per instruction. The scalar
+ * functions are the reference, every path gives bit identical results.
+ *
+ * A channel multiplied by 255 stays the same and one multiplied by 0 becomes 0:
+ *   modulate  c * f           (c * f + 255) >> 8
+ *   add       c + a           saturated at 255
+ *   lerp      c + (a - c) * t (c * (256 - t') + a * t') >> 8, with t' = t + (t >> 7) so that t = 255 gives a
+ */
+
+[[nodiscard]] constexpr auto modulate_color(const std::uint32_t color, const std::uint32_t factor) noexcept -> std::uint32_t {
+  std::uint32_t result = 0;
+  for (int shift = 0; shift < 32; shift += 8) {
+    const auto c = (color >> shift) & 0xFF;
+    const auto f = (factor >> shift) & 0xFF;
+    result |= ((c * f + 255) >> 8) << shift;
+  }
+  return result;
+}
+
+[[nodiscard]] constexpr auto add_color(const std::uint32_t color, const std::uint32_t addend) noexcept -> std::uint32_t {
+  std::uint32_t result = 0;
+  for (int shift = 0; shift < 32; shift += 8) {
+    const auto sum = ((color >> shift) & 0xFF) + ((addend >> shift) & 0xFF);
+    result |= std::min<std::uint32_t>(sum, 255) << shift;
+  }
+  return result;
+}
+
+[[nodiscard]] constexpr auto lerp_color(const std::uint32_t color, const std::uint32_t target, const std::uint8_t t) noexcept
+    -> std::uint32_t {
+  const std::uint32_t weight = t + (t >> 7);
+  std::uint32_t result = 0;
+  for (int shift = 0; shift < 32; shift += 8) {
+    const auto c = (color >> shift) & 0xFF;
+    const auto a = (target >> shift) & 0xFF;
+    result |= ((c * (256 - weight) + a * weight) >> 8) << shift;
+  }
+  return result;
+}
+
+namespace detail {
+
+/*
+ * The same handful of integer instructions at every vector width. Unpacking and packing both work within 128 bit
+ * lanes, so a register unpacked to its low and high halves packs back to the original color order.
+ */
+
+#if SWR_HAS_SSE2
+struct Sse2 {
+  using Vec = __m128i;
+  static constexpr std::size_t WIDTH = 4;
+
+  static auto load(const std::uint32_t* p) noexcept { return _mm_loadu_si128(reinterpret_cast<const Vec*>(p)); }
+  static void store(std::uint32_t* p, const Vec v) noexcept { _mm_storeu_si128(reinterpret_cast<Vec*>(p), v); }
+  static auto set1(const std::uint32_t c) noexcept { return _mm_set1_epi32(std::bit_cast<int>(c)); }
+  static auto set1_16(const std::uint16_t c) noexcept { return _mm_set1_epi16(static_cast<short>(c)); }
+  static auto zero() noexcept { return _mm_setzero_si128(); }
+  static auto unpack_lo(const Vec v) noexcept { return _mm_unpacklo_epi8(v, zero()); }
+  static auto unpack_hi(const Vec v) noexcept { return _mm_unpackhi_epi8(v, zero()); }
+  static auto pack(const Vec lo, const Vec hi) noexcept { return _mm_packus_epi16(lo, hi); }
+  static auto mul16(const Vec a, const Vec b) noexcept { return _mm_mullo_epi16(a, b); }
+  static auto add16(const Vec a, const Vec b) noexcept { return _mm_add_epi16(a, b); }
+  static auto shift16(const Vec v) noexcept { return _mm_srli_epi16(v, 8); }
+  static auto adds8(const Vec a, const Vec b) noexcept { return _mm_adds_epu8(a, b); }
+};
+#endif
+
+#if SWR_HAS_AVX2
+struct Avx2 {
+  using Vec = __m256i;
+  static constexpr std::size_t WIDTH = 8;
+
+  static auto load(const std::uint32_t* p) noexcept { return _mm256_loadu_si256(reinterpret_cast<const Vec*>(p)); }
+  static void store(std::uint32_t* p, const Vec v) noexcept { _mm256_storeu_si256(reinterpret_cast<Vec*>(p), v); }
+  static auto set1(const std::uint32_t c) noexcept { return _mm256_set1_epi32(std::bit_cast<int>(c)); }
+  static auto set1_16(const std::uint16_t c) noexcept { return _mm256_set1_epi16(static_cast<short>(c)); }
+  static auto zero() noexcept { return _mm256_setzero_si256(); }
+  static auto unpack_lo(const Vec v) noexcept { return _mm256_unpacklo_epi8(v, zero()); }
+  static auto unpack_hi(const Vec v) noexcept { return _mm256_unpackhi_epi8(v, zero()); }
+  static auto pack(const Vec lo, const Vec hi) noexcept { return _mm256_packus_epi16(lo, hi); }
+  static auto mul16(const Vec a, const Vec b) noexcept { return _mm256_mullo_epi16(a, b); }
+  static auto add16(const Vec a, const Vec b) noexcept { return _mm256_add_epi16(a, b); }
+  static auto shift16(const Vec v) noexcept { return _mm256_srli_epi16(v, 8); }
+  static auto adds8(const Vec a, const Vec b) noexcept { return _mm256_adds_epu8(a, b); }
+};
+#endif
+
+#if SWR_HAS_AVX512BW
+struct Avx512 {
+  using Vec = __m512i;
+  static constexpr std::size_t WIDTH = 16;
+
+  static auto load(const std::uint32_t* p) noexcept { return _mm512_loadu_si512(p); }
+  static void store(std::uint32_t* p, const Vec v) noexcept { _mm512_storeu_si512(p, v); }
+  static auto set1(const std::uint32_t c) noexcept { return _mm512_set1_epi32(std::bit_cast<int>(c)); }
+  static auto set1_16(const std::uint16_t c) noexcept { return _mm512_set1_epi16(static_cast<short>(c)); }
+  static auto zero() noexcept { return _mm512_setzero_si512(); }
+  static auto unpack_lo(const Vec v) noexcept { return _mm512_unpacklo_epi8(v, zero()); }
+  static auto unpack_hi(const Vec v) noexcept { return _mm512_unpackhi_epi8(v, zero()); }
+  static auto pack(const Vec lo, const Vec hi) noexcept { return _mm512_packus_epi16(lo, hi); }
+  static auto mul16(const Vec a, const Vec b) noexcept { return _mm512_mullo_epi16(a, b); }
+  static auto add16(const Vec a, const Vec b) noexcept { return _mm512_add_epi16(a, b); }
+  static auto shift16(const Vec v) noexcept { return _mm512_srli_epi16(v, 8); }
+  static auto adds8(const Vec a, const Vec b) noexcept { return _mm512_adds_epu8(a, b); }
+};
+#endif
+
+// Runs op(v) -> v over whole registers of colors, returns how many colors were processed
+template <typename Isa, typename Op>
+inline auto transform_colors(std::uint32_t* colors, const std::size_t count, Op op) noexcept -> std::size_t {
+  std::size_t i = 0;
+  for (; i + Isa::WIDTH <= count; i += Isa::WIDTH) {
+    Isa::store(colors + i, op(Isa::load(colors + i)));
+  }
+  return i;
+}
+
+template <typename Isa>
+inline auto modulate_colors(std::uint32_t* colors, const std::size_t count, const std::uint32_t factor) noexcept -> std::size_t {
+  const auto f = Isa::unpack_lo(Isa::set1(factor));
+  const auto bias = Isa::set1_16(255);
+  return transform_colors<Isa>(colors, count, [&](const auto v) {
+    const auto lo = Isa::shift16(Isa::add16(Isa::mul16(Isa::unpack_lo(v), f), bias));
+    const auto hi = Isa::shift16(Isa::add16(Isa::mul16(Isa::unpack_hi(v), f), bias));
+    return Isa::pack(lo, hi);
+  });
+}
+
+template <typename Isa>
+inline auto add_colors(std::uint32_t* colors, const std::size_t count, const std::uint32_t addend) noexcept -> std::size_t {
+  const auto a = Isa::set1(addend);
+  return transform_colors<Isa>(colors, count, [&](const auto v) { return Isa::adds8(v, a); });
+}
+
+template <typename Isa>
+inline auto lerp_colors(std::uint32_t* colors, const std::size_t count, const std::uint32_t target, const std::uint8_t t) noexcept
+    -> std::size_t {
+  const auto weight = static_cast<std::uint16_t>(t + (t >> 7));
+  // a * t' is the same for every color, at most 255 * 256 and 16 bit lanes wrap, so the sum stays exact
+  const auto a = Isa::mul16(Isa::unpack_lo(Isa::set1(target)), Isa::set1_16(weight));
+  const auto keep = Isa::set1_16(static_cast<std::uint16_t>(256 - weight));
+  return transform_colors<Isa>(colors, count, [&](const auto v) {
+    const auto lo = Isa::shift16(Isa::add16(Isa::mul16(Isa::unpack_lo(v), keep), a));
+    const auto hi = Isa::shift16(Isa::add16(Isa::mul16(Isa::unpack_hi(v), keep), a));
+    return Isa::pack(lo, hi);
+  });
+}
+
+// Calls kernel with the widest instruction set available, then finishes the remaining colors with scalar
+template <typename Scalar, typename Kernel>
+inline void for_colors(std::uint32_t* colors, const std::size_t count, [[maybe_unused]] Kernel&& kernel, Scalar&& scalar) noexcept {
+  std::size_t i = 0;
+#if SWR_HAS_AVX512BW
+  i = kernel.template operator()<Avx512>(colors, count);
+#elif SWR_HAS_AVX2
+  i = kernel.template operator()<Avx2>(colors, count);
+#elif SWR_HAS_SSE2
+  i = kernel.template operator()<Sse2>(colors, count);
+#endif
+  for (; i < count; i++) {
+    colors[i] = scalar(colors[i]);
+  }
+}
+
+}  // namespace detail
+
+// Multiplies count colors per channel with factor
+inline void modulate_colors(std::uint32_t* colors, const std::size_t count, const std::uint32_t factor) noexcept {
+  detail::for_colors(
+      colors, count,
+      [&]<typename Isa>(std::uint32_t* c, const std::size_t n) { return detail::modulate_colors<Isa>(c, n, factor); },
+      [&](const std::uint32_t c) { return modulate_color(c, factor); });
+}
+
+// Adds addend to count colors per channel, saturating
+inline void add_colors(std::uint32_t* colors, const std::size_t count, const std::uint32_t addend) noexcept {
+  detail::for_colors(
+      colors, count,
+      [&]<typename Isa>(std::uint32_t* c, const std::size_t n) { return detail::add_colors<Isa>(c, n, addend); },
+      [&](const std::uint32_t c) { return add_color(c, addend); });
+}
+
+// Moves count colors towards target by t / 255 per channel
+inline void lerp_colors(std::uint32_t* colors, const std::size_t count, const std::uint32_t target, const std::uint8_t t) noexcept {
+  detail::for_colors(
+      colors, count,
+      [&]<typename Isa>(std::uint32_t* c, const std::size_t n) { return detail::lerp_colors<Isa>(c, n, target, t); },
+      [&](const std::uint32_t c) { return lerp_color(c, target, t); });
+}
+
+}  // namespace swr::simd
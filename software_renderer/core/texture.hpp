@@ -0,0 +1,308 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+#include "pods.hpp"
+#include "simd.hpp"
+#include "job_system.hpp"
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+namespace swr {
+
+/**
+ * Texel addressing for the supported texture layouts.
+ *
+ * With the Morton layout texels that are close in 2D are close in memory in every direction, so a sampler walking
+ * down a texture column touches the same cache lines as one walking along a row. Square textures are a single
+ * Z-order curve, rectangular ones are a row (or column) of square Z-order blocks with the side of the short edge.
+ */
+
+// spreads the lower 16 bits of v so there is a zero bit between each of them
+[[nodiscard]] constexpr auto morton_spread(std::uint32_t v) noexcept -> std::uint32_t {
+#if defined(__BMI2__)
+  if !consteval {
+    return _pdep_u32(v, 0x55555555);
+  }
+#endif
+  v &= 0x0000FFFF;
+  v = (v | (v << 8)) & 0x00FF00FF;
+  v = (v | (v << 4)) & 0x0F0F0F0F;
+  v = (v | (v << 2)) & 0x33333333;
+  v = (v | (v << 1)) & 0x55555555;
+  return v;
+}
+
+[[nodiscard]] constexpr auto morton_index(const std::uint32_t x, const std::uint32_t y, const std::uint32_t width,
+                                          const std::uint32_t height) noexcept -> std::uint32_t {
+  const auto block = width < height ? width : height;
+  const auto block_mask = block - 1;
+  const auto block_shift = static_cast<std::uint32_t>(std::countr_zero(block));
+
+  // only one of the two has bits above the block size
+  const auto block_index = (x >> block_shift) + (y >> block_shift);
+
+  return (block_index * block * block) + (morton_spread(x & block_mask) | (morton_spread(y & block_mask) << 1));
+}
+
+// Index into Texture::texels of the texel at (x, y) of a texture with the given layout, x and y must be inside it
+template <TextureLayout Layout>
+[[nodiscard]] constexpr auto texel_index(const Texture& texture, const std::uint32_t x, const std::uint32_t y) noexcept
+    -> std::uint32_t {
+  if constexpr (Layout == TextureLayout::Morton) {
+    return morton_index(x, y, texture.width, texture.height);
+  } else {
+    return texture.width * y + x;
+  }
+}
+
+// Same for any layout, samplers have theirs baked in instead of branching per texel
+[[nodiscard]] constexpr auto texel_index(const Texture& texture, const std::uint32_t x, const std::uint32_t y) noexcept
+    -> std::uint32_t {
+  if (texture.layout == TextureLayout::Morton) {
+    return texel_index<TextureLayout::Morton>(texture, x, y);
+  }
+  return texel_index<TextureLayout::Linear>(texture, x, y);
+}
+
+[[nodiscard]] constexpr auto supports_layout(const std::uint32_t width, const std::uint32_t height,
+                                             const TextureLayout layout) noexcept -> bool {
+  if (layout == TextureLayout::Morton) {
+    return std::has_single_bit(width) && std::has_single_bit(height) && width <= 0x10000 && height <= 0x10000;
+  }
+  return true;
+}
+
+/**
+ * @brief Reorders a row-major texture and its mip chain into the requested layout.
+ * Layouts the texture dimensions do not support leave it linear.
+ */
+inline void swizzle_texture(Texture& texture, const TextureLayout layout) {
+  if (texture.layout != TextureLayout::Linear || layout == TextureLayout::Linear ||
+      !supports_layout(texture.width, texture.height, layout)) {
+    return;
+  }
+
+  std::vector<std::uint32_t> linear = std::move(texture.texels);
+  texture.layout = layout;
+  texture.texels.resize(linear.size());
+
+  for (std::uint32_t y = 0; y < texture.height; y++) {
+    for (std::uint32_t x = 0; x < texture.width; x++) {
+      texture.texels[texel_index(texture, x, y)] = linear[texture.width * y + x];
+    }
+  }
+
+  for (auto& mip : texture.mips) {
+    swizzle_texture(mip, layout);
+  }
+}
+
+// average of four ARGB texels, two channels at a time in 16 bit lanes
+[[nodiscard]] constexpr auto average_texels(const std::uint32_t t0, const std::uint32_t t1, const std::uint32_t t2,
+                                            const std::uint32_t t3) noexcept -> std::uint32_t {
+  const auto rb = ((t0 & 0x00FF00FF) + (t1 & 0x00FF00FF) + (t2 & 0x00FF00FF) + (t3 & 0x00FF00FF) + 0x00020002) >> 2;
+  const auto ag = (((t0 >> 8) & 0x00FF00FF) + ((t1 >> 8) & 0x00FF00FF) + ((t2 >> 8) & 0x00FF00FF) +
+                   ((t3 >> 8) & 0x00FF00FF) + 0x00020002) >> 2;
+  return (rb & 0x00FF00FF) | ((ag & 0x00FF00FF) << 8);
+}
+
+/**
+ * @brief Builds the mip chain of a linear texture with a 2x2 box filter.
+ * Each level depends on the previous one, the rows of a level are filtered in parallel when a job system is given.
+ */
+inline void generate_mipmaps(Texture& texture, JobSystem* jobs = nullptr) {
+  // texels filtered per job, small levels are not worth splitting into many jobs
+  constexpr std::size_t TEXELS_PER_JOB = 16 * 1024;
+
+  texture.mips.clear();
+  if (texture.layout != TextureLayout::Linear || texture.texels.empty()) {
+    return;
+  }
+
+  // levels are referenced while the next one is built, so the vector must not reallocate
+  texture.mips.reserve(static_cast<std::size_t>(std::bit_width(std::max(texture.width, texture.height))));
+
+  const Texture* source = &texture;
+
+  while (source->width > 1 || source->height > 1) {
+    Texture level{};
+    level.width = std::max(source->width / 2, 1u);
+    level.height = std::max(source->height / 2, 1u);
+    level.power_of_two = std::has_single_bit(level.width) && std::has_single_bit(level.height);
+    level.texels.resize(static_cast<std::size_t>(level.width) * level.height);
+
+    const auto filter_row = [&](const std::size_t row) {
+      const auto y = static_cast<std::uint32_t>(row);
+      const auto* top = source->texels.data() + static_cast<std::size_t>(source->width) * std::min(2 * y, source->height - 1);
+      const auto* bottom = source->texels.data() + static_cast<std::size_t>(source->width) * std::min(2 * y + 1, source->height - 1);
+      auto* out = level.texels.data() + static_cast<std::size_t>(level.width) * y;
+
+      for (std::uint32_t x = 0; x < level.width; x++) {
+        const auto x0 = std::min(2 * x, source->width - 1);
+        const auto x1 = std::min(2 * x + 1, source->width - 1);
+        out[x] = average_texels(top[x0], top[x1], bottom[x0], bottom[x1]);
+      }
+    };
+
+    if (jobs != nullptr) {
+      jobs->parallel_for(level.height, std::max<std::size_t>(1, TEXELS_PER_JOB / level.width), filter_row);
+    } else {
+      for (std::size_t y = 0; y < level.height; y++) {
+        filter_row(y);
+      }
+    }
+
+    texture.mips.push_back(std::move(level));
+    source = &texture.mips.back();
+  }
+}
+
+[[nodiscard]] constexpr auto floor_to_int(const float value) noexcept -> int {
+  const auto truncated = static_cast<int>(value);
+  return truncated - (value < static_cast<float>(truncated) ? 1 : 0);
+}
+
+// Maps an integer texel coordinate into [0, size) according to the wrap mode
+template <TextureWrap Wrap, bool PowerOfTwo>
+[[nodiscard]] constexpr auto wrap_coord(const int coord, const std::uint32_t size) noexcept -> std::uint32_t {
+  const auto n = static_cast<int>(size);
+
+  if constexpr (Wrap == TextureWrap::Clamp) {
+    return static_cast<std::uint32_t>(std::clamp(coord, 0, n - 1));
+  } else if constexpr (Wrap == TextureWrap::Repeat) {
+    if constexpr (PowerOfTwo) {
+      return static_cast<std::uint32_t>(coord & (n - 1));
+    } else {
+      const auto m = coord % n;
+      return static_cast<std::uint32_t>(m < 0 ? m + n : m);
+    }
+  } else {
+    // mirrored repeat has a period of two texture sizes, the second half runs backwards
+    auto m = 0;
+    if constexpr (PowerOfTwo) {
+      m = coord & (2 * n - 1);
+    } else {
+      m = coord % (2 * n);
+      m = m < 0 ? m + 2 * n : m;
+    }
+    return static_cast<std::uint32_t>(m >= n ? 2 * n - 1 - m : m);
+  }
+}
+
+/**
+ * @brief Blends a 2x2 texel neighbourhood, fx and fy are the 7 bit fixed point fractions towards t10 and t01.
+ *
+ * The four weights are 14 bit and add up to 1 << 14, channels are multiplied and summed pairwise in 32 bit lanes.
+ */
+[[nodiscard]] inline auto bilinear_blend(const std::uint32_t t00, const std::uint32_t t10, const std::uint32_t t01,
+                                         const std::uint32_t t11, const std::uint32_t fx, const std::uint32_t fy) noexcept
+    -> std::uint32_t {
+  const auto w00 = (128 - fx) * (128 - fy);
+  const auto w10 = fx * (128 - fy);
+  const auto w01 = (128 - fx) * fy;
+  const auto w11 = fx * fy;
+
+#if SWR_HAS_SSE2
+  const auto zero = _mm_setzero_si128();
+
+  // 16 bit lanes of interleaved channels: b00 b10 g00 g10 r00 r10 a00 a10
+  const auto top = _mm_unpacklo_epi8(
+      _mm_unpacklo_epi8(_mm_cvtsi32_si128(static_cast<int>(t00)), _mm_cvtsi32_si128(static_cast<int>(t10))), zero);
+  const auto bottom = _mm_unpacklo_epi8(
+      _mm_unpacklo_epi8(_mm_cvtsi32_si128(static_cast<int>(t01)), _mm_cvtsi32_si128(static_cast<int>(t11))), zero);
+
+  const auto top_weights = _mm_set1_epi32(static_cast<int>((w10 << 16) | w00));
+  const auto bottom_weights = _mm_set1_epi32(static_cast<int>((w11 << 16) | w01));
+
+  auto sum = _mm_add_epi32(_mm_madd_epi16(top, top_weights), _mm_madd_epi16(bottom, bottom_weights));
+  sum = _mm_srli_epi32(_mm_add_epi32(sum, _mm_set1_epi32(1 << 13)), 14);
+  sum = _mm_packs_epi32(sum, sum);
+  sum = _mm_packus_epi16(sum, sum);
+
+  return static_cast<std::uint32_t>(_mm_cvtsi128_si32(sum));
+#else
+  std::uint32_t result = 0;
+  for (std::uint32_t shift = 0; shift < 32; shift += 8) {
+    const auto channel = ((t00 >> shift) & 0xFF) * w00 + ((t10 >> shift) & 0xFF) * w10 + ((t01 >> shift) & 0xFF) * w01 +
+                         ((t11 >> shift) & 0xFF) * w11;
+    result |= ((channel + (1 << 13)) >> 14) << shift;
+  }
+  return result;
+#endif
+}
+
+/**
+ * Texture lookup with the filter, wrap mode, power of two fast path and texel layout baked in.
+ * Use with_sampler to pick the specialization once per triangle instead of branching per texel.
+ */
+template <TextureFilter Filter, TextureWrap Wrap, bool PowerOfTwo, TextureLayout Layout = TextureLayout::Linear>
+struct TextureSampler {
+  const Texture& texture;
+
+  [[nodiscard]] auto operator()(const float u, const float v) const noexcept -> std::uint32_t {
+    if constexpr (Filter == TextureFilter::Nearest) {
+      const auto x = wrap_coord<Wrap, PowerOfTwo>(floor_to_int(u * static_cast<float>(texture.width)), texture.width);
+      const auto y = wrap_coord<Wrap, PowerOfTwo>(floor_to_int(v * static_cast<float>(texture.height)), texture.height);
+      return texture.texels[texel_index<Layout>(texture, x, y)];
+    } else {
+      // texel centers are at half coordinates, 7 fractional bits
+      const auto fu = floor_to_int((u * static_cast<float>(texture.width) - 0.5f) * 128.0f);
+      const auto fv = floor_to_int((v * static_cast<float>(texture.height) - 0.5f) * 128.0f);
+
+      const auto x0 = wrap_coord<Wrap, PowerOfTwo>(fu >> 7, texture.width);
+      const auto x1 = wrap_coord<Wrap, PowerOfTwo>((fu >> 7) + 1, texture.width);
+      const auto y0 = wrap_coord<Wrap, PowerOfTwo>(fv >> 7, texture.height);
+      const auto y1 = wrap_coord<Wrap, PowerOfTwo>((fv >> 7) + 1, texture.height);
+
+      const auto* texels = texture.texels.data();
+      return bilinear_blend(texels[texel_index<Layout>(texture, x0, y0)], texels[texel_index<Layout>(texture, x1, y0)],
+                            texels[texel_index<Layout>(texture, x0, y1)], texels[texel_index<Layout>(texture, x1, y1)],
+                            static_cast<std::uint32_t>(fu & 127), static_cast<std::uint32_t>(fv & 127));
+    }
+  }
+};
+
+template <TextureFilter Filter, TextureWrap Wrap, typename Fn>
+void with_sampler(const Texture& texture, Fn&& fn) {
+  // the Morton layout is only used for power of two textures
+  if (texture.layout == TextureLayout::Morton) {
+    fn(TextureSampler<Filter, Wrap, true, TextureLayout::Morton>{texture});
+  } else if (texture.power_of_two) {
+    fn(TextureSampler<Filter, Wrap, true>{texture});
+  } else {
+    fn(TextureSampler<Filter, Wrap, false>{texture});
+  }
+}
+
+template <TextureFilter Filter, typename Fn>
+void with_sampler(const Texture& texture, const TextureWrap wrap, Fn&& fn) {
+  switch (wrap) {
+    case TextureWrap::Repeat:
+      with_sampler<Filter, TextureWrap::Repeat>(texture, fn);
+      break;
+    case TextureWrap::Clamp:
+      with_sampler<Filter, TextureWrap::Clamp>(texture, fn);
+      break;
+    case TextureWrap::Mirror:
+      with_sampler<Filter, TextureWrap::Mirror>(texture, fn);
+      break;
+  }
+}
+
+// Calls fn with the TextureSampler matching the sampler state and the texture
+template <typename Fn>
+void with_sampler(const Texture& texture, const SamplerState& state, Fn&& fn) {
+  if (state.filter == TextureFilter::Bilinear) {
+    with_sampler<TextureFilter::Bilinear>(texture, state.wrap, fn);
+  } else {
+    with_sampler<TextureFilter::Nearest>(texture, state.wrap, fn);
+  }
+}
+
+}  // namespace swr
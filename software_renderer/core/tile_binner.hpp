@@ -0,0 +1,74 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "canvas.hpp"
+#include "pods.hpp"
+
+namespace swr {
+
+/**
+ * Splits the screen into the same TILE_SIZE x TILE_SIZE tiles the canvas uses for lazy clears and records,
+ * per tile, the draw commands overlapping it.
+ * Commands are appended in submission order so every tile replays them in the same order as a serial renderer would.
+ */
+class TileBinner {
+ public:
+  static constexpr int TILE_SIZE = Canvas::TILE_SIZE;
+
+  explicit TileBinner(const int width, const int height)
+      : width_{width},
+        height_{height},
+        tiles_x_{(width + TILE_SIZE - 1) / TILE_SIZE},
+        tiles_y_{(height + TILE_SIZE - 1) / TILE_SIZE},
+        bins_(static_cast<std::size_t>(tiles_x_ * tiles_y_)) {}
+
+  [[nodiscard]] auto tile_count() const noexcept -> std::size_t { return bins_.size(); }
+
+  [[nodiscard]] auto tile_rect(const std::size_t tile_index) const noexcept -> Rect {
+    const auto tx = static_cast<int>(tile_index) % tiles_x_;
+    const auto ty = static_cast<int>(tile_index) / tiles_x_;
+
+    return Rect{tx * TILE_SIZE, ty * TILE_SIZE, std::min((tx + 1) * TILE_SIZE, width_), std::min((ty + 1) * TILE_SIZE, height_)};
+  }
+
+  [[nodiscard]] auto tile_bin(const std::size_t tile_index) const noexcept -> const std::vector<std::uint32_t>& {
+    return bins_[tile_index];
+  }
+
+  void clear() {
+    // keep the capacity of every bin around for the next frame
+    for (auto& bin : bins_) {
+      bin.clear();
+    }
+  }
+
+  void bin(const std::uint32_t command_index, const Rect& bounds) {
+    const auto visible = intersect(bounds, Rect{0, 0, width_, height_});
+    if (visible.empty()) {
+      return;
+    }
+
+    const auto tx0 = visible.min_x / TILE_SIZE;
+    const auto ty0 = visible.min_y / TILE_SIZE;
+    const auto tx1 = (visible.max_x - 1) / TILE_SIZE;
+    const auto ty1 = (visible.max_y - 1) / TILE_SIZE;
+
+    for (int ty = ty0; ty <= ty1; ty++) {
+      for (int tx = tx0; tx <= tx1; tx++) {
+        bins_[static_cast<std::size_t>(ty * tiles_x_ + tx)].push_back(command_index);
+      }
+    }
+  }
+
+ private:
+  int width_;
+  int height_;
+  int tiles_x_;
+  int tiles_y_;
+  std::vector<std::vector<std::uint32_t>> bins_;
+};
+
+}  // namespace swr
@@ -1,9 +1,16 @@
 #pragma once
 
+#include <bit>
 #include <cstdint>
 #include <functional>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <unordered_map>
 
+#include "components.hpp"
 #include "pods.hpp"
+#include "texture.hpp"
 
 #include "stb_image.h"
 #include <tiny_obj_loader.h>
@@ -12,17 +19,15 @@
 
 namespace swr {
 
-static std::uint32_t light_apply_intensity(const std::uint32_t original_color, float percentage_factor) {
-  const std::uint32_t a = (original_color & 0xFF000000);
-  const auto r = static_cast<std::uint32_t>(static_cast<float>((original_color & 0x00FF0000)) * percentage_factor);
-  const auto g = static_cast<std::uint32_t>(static_cast<float>((original_color & 0x0000FF00)) * percentage_factor);
-  const auto b = static_cast<std::uint32_t>(static_cast<float>((original_color & 0x000000FF)) * percentage_factor);
-
-  const std::uint32_t new_color = a | (r & 0x00FF0000) | (g & 0x0000FF00) | (b & 0x000000FF);
-  return new_color;
-}
+struct TextureOptions {
+  // Morton is only applied to power of two textures, others stay linear
+  TextureLayout layout = TextureLayout::Linear;
+  bool generate_mipmaps = false;
+  // optional job system used for asset processing, such as filtering mip levels
+  JobSystem* jobs = nullptr;
+};
 
-static Texture load_texture(const std::string& filename) {
+static Texture load_texture(const std::string& filename, const TextureOptions& options = {}) {
   int width, height;
   unsigned char *data = stbi_load(filename.c_str(), &width, &height, nullptr, 4);
 
@@ -34,9 +39,11 @@ static Texture load_texture(const std::string& filename) {
   Texture t{};
   t.width = width;
   t.height = height;
+  t.power_of_two = std::has_single_bit(t.width) && std::has_single_bit(t.height);
+  t.texels.reserve(static_cast<std::size_t>(width) * static_cast<std::size_t>(height));
 
-  for (int i = 0; i < width; i++) {
-    for (int j = 0; j < height; j++) {
+  for (int j = 0; j < height; j++) {
+    for (int i = 0; i < width; i++) {
       const unsigned char* pixel_offset = data + (width * j + i) * 4;
       const unsigned char r = pixel_offset[0];
       const unsigned char g = pixel_offset[1];
@@ -49,6 +56,12 @@ static Texture load_texture(const std::string& filename) {
   }
 
   stbi_image_free(data);
+
+  if (options.generate_mipmaps) {
+    generate_mipmaps(t, options.jobs);
+  }
+
+  swizzle_texture(t, options.layout);
   return t;
 }
 
@@ -62,7 +75,8 @@ struct std::hash<swr::Vertex> {
   }
 };
 
-static DrawableComponent load_model(const std::string& filename, const std::optional<std::string>& texture_filename = std::nullopt) {
+static DrawableComponent load_model(const std::string& filename, const std::optional<std::string>& texture_filename = std::nullopt,
+                                    const TextureOptions& texture_options = {}) {
   namespace bm = bonfire::math;
 
   tinyobj::attrib_t attrib;
@@ -89,7 +103,7 @@ static DrawableComponent load_model(const std::string& filename, const std::opti
   DrawableComponent dc{};
 
   if (texture_filename.has_value()) {
-    dc.texture = load_texture(*texture_filename);
+    dc.texture = load_texture(*texture_filename, texture_options);
   }
 
   std::unordered_map<Vertex, uint32_t> unique_vertices{};
@@ -112,6 +126,14 @@ static DrawableComponent load_model(const std::string& filename, const std::opti
       if (!unique_vertices.contains(vertex)) {
         unique_vertices[vertex] = static_cast<uint32_t>(dc.vertices.size());
         dc.vertices.push_back(vertex);
+
+        if (index.normal_index >= 0) {
+          dc.vertices.set_normal(dc.vertices.size() - 1, bm::float3{
+            attrib.normals[3 * index.normal_index + 0],
+            attrib.normals[3 * index.normal_index + 1],
+            attrib.normals[3 * index.normal_index + 2]
+          });
+        }
       }
 
       dc.indices.push_back(unique_vertices[vertex]);
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <ranges>
+#include <span>
+#include <vector>
+
+#include <math/vector2.hpp>
+#include <math/vector3.hpp>
+
+namespace swr {
+
+// Allocator for vectors whose data must start on an Alignment byte boundary
+template <typename T, std::size_t Alignment>
+struct AlignedAllocator {
+  using value_type = T;
+
+  template <typename U>
+  struct rebind {
+    using other = AlignedAllocator<U, Alignment>;
+  };
+
+  constexpr AlignedAllocator() noexcept = default;
+
+  template <typename U>
+  constexpr AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept {}
+
+  [[nodiscard]] auto allocate(const std::size_t count) -> T* {
+    return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t{Alignment}));
+  }
+
+  void deallocate(T* pointer, std::size_t) noexcept { ::operator delete(pointer, std::align_val_t{Alignment}); }
+
+  template <typename U>
+  constexpr auto operator==(const AlignedAllocator<U, Alignment>&) const noexcept -> bool {
+    return true;
+  }
+};
+
+struct Vertex {
+  bonfire::math::float3 pos;
+  bonfire::math::float2 uv;
+
+  constexpr auto operator==(const Vertex& other) const -> bool {
+    return pos == other.pos;
+  }
+};
+
+/**
+ * Vertices of a mesh stored as one stream per component (structure of arrays). Every stream starts on a cache
+ * line, so a pass that only needs positions reads nothing but x, y and z and can process them with full SIMD
+ * loads. Normals are optional, the normal streams exist once a normal was set and then hold one per vertex.
+ *
+ * operator[] and as_vertices() assemble interleaved Vertex values for code that wants one vertex at a time.
+ */
+class VertexBuffer {
+ public:
+  // alignment of every stream, a cache line
+  static constexpr std::size_t STREAM_ALIGNMENT = 64;
+
+  using Stream = std::vector<float, AlignedAllocator<float, STREAM_ALIGNMENT>>;
+
+  [[nodiscard]] auto size() const noexcept -> std::size_t { return x_.size(); }
+  [[nodiscard]] auto empty() const noexcept -> bool { return x_.empty(); }
+  [[nodiscard]] auto has_normals() const noexcept -> bool { return !normal_x_.empty(); }
+
+  void reserve(const std::size_t count) {
+    for (auto* stream : {&x_, &y_, &z_, &u_, &v_}) {
+      stream->reserve(count);
+    }
+  }
+
+  void clear() noexcept {
+    for (auto* stream : {&x_, &y_, &z_, &u_, &v_, &normal_x_, &normal_y_, &normal_z_}) {
+      stream->clear();
+    }
+  }
+
+  void push_back(const Vertex& vertex) {
+    x_.push_back(vertex.pos.x);
+    y_.push_back(vertex.pos.y);
+    z_.push_back(vertex.pos.z);
+    u_.push_back(vertex.uv.x);
+    v_.push_back(vertex.uv.y);
+
+    if (has_normals()) {
+      normal_x_.push_back(0.0f);
+      normal_y_.push_back(0.0f);
+      normal_z_.push_back(0.0f);
+    }
+  }
+
+  // Vertices without a normal of their own keep a zero normal
+  void set_normal(const std::size_t index, const bonfire::math::float3& normal) {
+    if (!has_normals()) {
+      normal_x_.resize(size(), 0.0f);
+      normal_y_.resize(size(), 0.0f);
+      normal_z_.resize(size(), 0.0f);
+    }
+    normal_x_[index] = normal.x;
+    normal_y_[index] = normal.y;
+    normal_z_[index] = normal.z;
+  }
+
+  [[nodiscard]] auto x() const noexcept -> std::span<const float> { return x_; }
+  [[nodiscard]] auto y() const noexcept -> std::span<const float> { return y_; }
+  [[nodiscard]] auto z() const noexcept -> std::span<const float> { return z_; }
+  [[nodiscard]] auto u() const noexcept -> std::span<const float> { return u_; }
+  [[nodiscard]] auto v() const noexcept -> std::span<const float> { return v_; }
+  [[nodiscard]] auto normal_x() const noexcept -> std::span<const float> { return normal_x_; }
+  [[nodiscard]] auto normal_y() const noexcept -> std::span<const float> { return normal_y_; }
+  [[nodiscard]] auto normal_z() const noexcept -> std::span<const float> { return normal_z_; }
+
+  [[nodiscard]] auto position(const std::size_t index) const noexcept -> bonfire::math::float3 {
+    return bonfire::math::float3{x_[index], y_[index], z_[index]};
+  }
+
+  [[nodiscard]] auto uv(const std::size_t index) const noexcept -> bonfire::math::float2 {
+    return bonfire::math::float2{u_[index], v_[index]};
+  }
+
+  [[nodiscard]] auto normal(const std::size_t index) const noexcept -> bonfire::math::float3 {
+    return bonfire::math::float3{normal_x_[index], normal_y_[index], normal_z_[index]};
+  }
+
+  [[nodiscard]] auto operator[](const std::size_t index) const noexcept -> Vertex {
+    return Vertex{position(index), uv(index)};
+  }
+
+  // Range of all vertices as Vertex values
+  [[nodiscard]] auto as_vertices() const {
+    return std::views::iota(std::size_t{0}, size()) |
+           std::views::transform([this](const std::size_t index) { return (*this)[index]; });
+  }
+
+ private:
+  Stream x_{}, y_{}, z_{};
+  Stream u_{}, v_{};
+  Stream normal_x_{}, normal_y_{}, normal_z_{};
+};
+
+}  // namespace swr
@@ -4,9 +4,11 @@
 #include <math/vector2.hpp>
 #include <math/vector3.hpp>
 #include <math/face.hpp>
+#include <string_view>
 #include <vector>
 
 #include "core/renderer.hpp"
+#include "core/sdl_presenter.hpp"
 
 #include <internal_use_only/swr_config.hpp>
 
@@ -15,8 +17,24 @@ namespace bm = bonfire::math;
 constexpr static auto WIDTH = 1280;
 constexpr static auto HEIGHT = 720;
 
-int main() {
-  swr::Renderer renderer{WIDTH, HEIGHT};
+/*
+ * Usage:
+ *   software_renderer                                    interactive SDL window
+ *   software_renderer --headless [frames] [output_dir]   render frames without a window and print the average frame
+ *                                                        time, every frame is written to output_dir as ppm if given
+ */
+int main(int argc, char* argv[]) {
+  const bool headless = argc > 1 && std::string_view{argv[1]} == "--headless";
+  const std::size_t headless_frames = argc > 2 ? std::stoul(argv[2]) : 300;
+
+  std::unique_ptr<swr::Presenter> presenter;
+  if (headless) {
+    presenter = std::make_unique<swr::HeadlessPresenter>(argc > 3 ? swr::write_frames_to(argv[3]) : swr::HeadlessPresenter::FrameCallback{});
+  } else {
+    presenter = std::make_unique<swr::SdlPresenter>();
+  }
+
+  swr::Renderer renderer{WIDTH, HEIGHT, std::move(presenter)};
 
   if (const auto res = renderer.initialize(); !res) {
     return -1;
@@ -26,7 +44,8 @@ int main() {
   std::string texture_file = std::string(swr::CONTENT_BASE_PATH) + "/f117.png";
 
   swr::Entity e{};
-  e.drawable = swr::load_model(model_file, texture_file);
+  e.drawable = swr::load_model(model_file, texture_file,
+                               swr::TextureOptions{.layout = swr::TextureLayout::Morton, .generate_mipmaps = true, .jobs = &renderer.jobs()});
   e.transform.position.z = 5.0f;
   e.transform.scale = bm::float3{1.0f, 1.0f, 1.0f};
 
@@ -40,7 +59,13 @@ int main() {
 
   renderer.add_entity(std::move(e));
 
-  renderer.render_forever();
+  if (headless) {
+    const auto frame_time = renderer.render_frames(headless_frames);
+    std::cout << headless_frames << " frames, " << frame_time << " ms/frame, "
+              << renderer.stats().shaded_per_pixel() << " shaded pixels per pixel" << std::endl;
+  } else {
+    renderer.render_forever();
+  }
 
   return 0;
 }
@@ -0,0 +1,40 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+
+#include <math/transformation.hpp>
+
+#include <cstddef>
+
+namespace bm = bonfire::math;
+
+namespace {
+
+auto approx_equal(const bm::float4& lhs, const bm::float4& rhs) -> bool {
+  constexpr float EPSILON = 1e-4f;
+  return lhs.x == Catch::Approx(rhs.x).margin(EPSILON) && lhs.y == Catch::Approx(rhs.y).margin(EPSILON) &&
+         lhs.z == Catch::Approx(rhs.z).margin(EPSILON) && lhs.w == Catch::Approx(rhs.w).margin(EPSILON);
+}
+
+}  // namespace
+
+TEST_CASE( "Inverse world matrix undoes the world matrix", "[Transformation]" ) {
+  // non uniform, and one axis mirrored
+  const bm::float3 scales[] = {bm::float3{1.0f, 1.0f, 1.0f}, bm::float3{2.0f, 0.5f, 3.0f}, bm::float3{-1.5f, 4.0f, 0.25f}};
+  const bm::float3 rotation{0.3f, -1.2f, 2.5f};
+  const bm::float3 position{10.0f, -4.0f, 7.5f};
+
+  for (const auto& scale : scales) {
+    const auto world = bm::make_world_matrix(scale, rotation, position);
+    const auto inverse = bm::make_inverse_world_matrix(scale, rotation, position);
+
+    const auto identity = bm::Mat4::identity();
+    const auto product = inverse * world;
+    for (std::size_t column = 0; column < 4; column++) {
+      REQUIRE(approx_equal(product.column(column), identity.column(column)));
+    }
+
+    const bm::float4 point{1.0f, -2.0f, 3.0f, 1.0f};
+    REQUIRE(approx_equal(inverse * (world * point), point));
+    REQUIRE(approx_equal(world * (inverse * point), point));
+  }
+}
@@ -0,0 +1,124 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "core/clipper.hpp"
+
+namespace bm = bonfire::math;
+
+namespace {
+
+auto vertex(const float x, const float y, const float z, const float w, const float u = 0.0f, const float v = 0.0f) -> swr::ClipVertex {
+  return swr::ClipVertex{bm::float4{x, y, z, w}, bm::float2{u, v}};
+}
+
+auto planes_of(const swr::ClipVertex& v0, const swr::ClipVertex& v1, const swr::ClipVertex& v2) -> std::uint8_t {
+  return swr::clip_code(v0.position) | swr::clip_code(v1.position) | swr::clip_code(v2.position);
+}
+
+// Every vertex of polygon is on the inside of every plane, with a little slack for the interpolation
+auto inside_all_planes(const swr::ClipPolygon& polygon) -> bool {
+  for (std::size_t i = 0; i < polygon.size; i++) {
+    for (std::size_t plane = 0; plane < swr::CLIP_PLANE_COUNT; plane++) {
+      if (swr::clip_distance(polygon.vertices[i].position, plane) < -1e-5f) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+TEST_CASE("A triangle inside the view volume is not clipped", "[Clipper]") {
+  const auto v0 = vertex(-0.5f, -0.5f, 0.0f, 1.0f);
+  const auto v1 = vertex(0.5f, -0.5f, 0.5f, 2.0f);
+  const auto v2 = vertex(0.0f, 0.5f, 0.9f, 1.0f);
+
+  REQUIRE(planes_of(v0, v1, v2) == 0);
+
+  swr::ClipPolygon polygon{};
+  REQUIRE(swr::clip_triangle(v0, v1, v2, 0, polygon));
+  REQUIRE(polygon.size == 3);
+  REQUIRE(polygon.vertices[1].position == v1.position);
+}
+
+TEST_CASE("A triangle outside of one plane is rejected", "[Clipper]") {
+  // all three beyond the far plane
+  const auto v0 = vertex(0.0f, 0.0f, 2.0f, 1.0f);
+  const auto v1 = vertex(0.5f, 0.0f, 3.0f, 1.0f);
+  const auto v2 = vertex(0.0f, 0.5f, 2.5f, 1.0f);
+
+  const auto shared = swr::clip_code(v0.position) & swr::clip_code(v1.position) & swr::clip_code(v2.position);
+  REQUIRE(shared == swr::CLIP_FAR);
+
+  swr::ClipPolygon polygon{};
+  REQUIRE_FALSE(swr::clip_triangle(v0, v1, v2, planes_of(v0, v1, v2), polygon));
+  REQUIRE(polygon.size == 0);
+}
+
+TEST_CASE("A vertex behind the eye is clipped away at the near plane", "[Clipper]") {
+  const auto v0 = vertex(0.0f, 0.0f, 0.5f, 1.0f);
+  const auto v1 = vertex(0.5f, 0.0f, 0.5f, 1.0f);
+  // w < 0, projecting it would mirror it to the other side of the screen
+  const auto behind = vertex(0.25f, 0.5f, -3.0f, -2.0f);
+
+  REQUIRE((swr::clip_code(behind.position) & swr::CLIP_NEAR) != 0);
+
+  swr::ClipPolygon polygon{};
+  REQUIRE(swr::clip_triangle(v0, v1, behind, planes_of(v0, v1, behind), polygon));
+  REQUIRE(polygon.size >= 3);
+  REQUIRE(inside_all_planes(polygon));
+  for (std::size_t i = 0; i < polygon.size; i++) {
+    REQUIRE(polygon.vertices[i].position.w > 0.0f);
+  }
+}
+
+TEST_CASE("A triangle straddling the near plane is cut with interpolated attributes", "[Clipper]") {
+  // z = -w is the near plane, v2 is in front of it and v0, v1 behind
+  const auto v0 = vertex(-1.0f, 0.0f, -2.0f, 1.0f, 0.0f, 0.0f);
+  const auto v1 = vertex(1.0f, 0.0f, -2.0f, 1.0f, 1.0f, 0.0f);
+  const auto v2 = vertex(0.0f, 0.0f, 2.0f, 3.0f, 0.5f, 1.0f);
+
+  REQUIRE(planes_of(v0, v1, v2) == swr::CLIP_NEAR);
+
+  swr::ClipPolygon polygon{};
+  REQUIRE(swr::clip_triangle(v0, v1, v2, swr::CLIP_NEAR, polygon));
+  // one vertex inside, the edges to it are cut, the one between the outside vertices is dropped
+  REQUIRE(polygon.size == 3);
+  REQUIRE(inside_all_planes(polygon));
+
+  std::size_t on_plane = 0;
+  for (std::size_t i = 0; i < polygon.size; i++) {
+    const auto& [position, uv] = polygon.vertices[i];
+    if (position == v2.position) {
+      continue;
+    }
+    on_plane++;
+    REQUIRE(position.z == Catch::Approx(-position.w));
+
+    // v0 and v1 have d = z + w = -1, v2 has d = 5, so the cut is a sixth of the way to v2
+    REQUIRE(position.w == Catch::Approx(1.0f + (3.0f - 1.0f) / 6.0f));
+    REQUIRE(uv.y == Catch::Approx(1.0f / 6.0f));
+  }
+  REQUIRE(on_plane == 2);
+}
+
+TEST_CASE("Triangles within the guard band are left to the scissor", "[Clipper]") {
+  // well off the right and top edge of the screen (|x|, |y| > w) but within the guard band
+  const auto v0 = vertex(1.5f, 0.0f, 0.0f, 1.0f);
+  const auto v1 = vertex(6.0f, 2.0f, 0.0f, 1.0f);
+  const auto v2 = vertex(3.0f, 7.5f, 0.0f, 1.0f);
+
+  REQUIRE(planes_of(v0, v1, v2) == 0);
+
+  // crossing the guard band does clip against the side plane
+  const auto far_right = vertex(swr::GUARD_BAND * 2.0f, 0.0f, 0.0f, 1.0f);
+  REQUIRE(swr::clip_code(far_right.position) == swr::CLIP_RIGHT);
+
+  swr::ClipPolygon polygon{};
+  REQUIRE(swr::clip_triangle(v0, v1, far_right, planes_of(v0, v1, far_right), polygon));
+  REQUIRE(inside_all_planes(polygon));
+}
@@ -0,0 +1,88 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+#include "core/job_system.hpp"
+
+TEST_CASE("parallel_for calls every index exactly once", "[JobSystem]") {
+  swr::JobSystem jobs{4};
+
+  for (const std::size_t count : {0, 1, 7, 1000, 4099}) {
+    for (const std::size_t grain : {1, 3, 64, 5000}) {
+      std::vector<std::atomic<int>> calls(count);
+      jobs.parallel_for(count, grain, [&](const std::size_t i) { calls[i].fetch_add(1, std::memory_order_relaxed); });
+
+      for (const auto& call : calls) {
+        REQUIRE(call.load() == 1);
+      }
+    }
+  }
+}
+
+TEST_CASE("Nested parallel_for completes", "[JobSystem]") {
+  swr::JobSystem jobs{4};
+
+  constexpr std::size_t OUTER = 16;
+  constexpr std::size_t INNER = 100;
+  std::vector<std::atomic<int>> calls(OUTER * INNER);
+
+  jobs.parallel_for(OUTER, [&](const std::size_t i) {
+    jobs.parallel_for(INNER, [&](const std::size_t j) { calls[i * INNER + j].fetch_add(1, std::memory_order_relaxed); });
+  });
+
+  for (const auto& call : calls) {
+    REQUIRE(call.load() == 1);
+  }
+}
+
+TEST_CASE("Dependent jobs run after their dependencies", "[JobSystem]") {
+  swr::JobSystem jobs{4};
+
+  constexpr int LENGTH = 50;
+  std::vector<int> order;
+  std::mutex mutex;
+
+  swr::JobSystem::JobHandle previous;
+  for (int i = 0; i < LENGTH; i++) {
+    previous = jobs.schedule(
+        [&, i] {
+          std::lock_guard lock{mutex};
+          order.push_back(i);
+        },
+        {previous});
+  }
+  jobs.wait(previous);
+
+  REQUIRE(order.size() == LENGTH);
+  for (int i = 0; i < LENGTH; i++) {
+    REQUIRE(order[i] == i);
+  }
+}
+
+TEST_CASE("A finished dependency does not hold back a job", "[JobSystem]") {
+  swr::JobSystem jobs{4};
+
+  std::atomic<int> runs{0};
+  const auto first = jobs.schedule([&] { runs.fetch_add(1); });
+  jobs.wait(first);
+  REQUIRE(runs.load() == 1);
+
+  const auto second = jobs.schedule([&] { runs.fetch_add(1); }, {first, nullptr});
+  jobs.wait(second);
+  REQUIRE(runs.load() == 2);
+}
+
+TEST_CASE("A single threaded system runs everything on the waiting thread", "[JobSystem]") {
+  swr::JobSystem jobs{1};
+  REQUIRE(jobs.size() == 1);
+
+  std::atomic<int> sum{0};
+  jobs.parallel_for(100, [&](const std::size_t i) { sum.fetch_add(static_cast<int>(i)); });
+  const auto job = jobs.schedule([&] { sum.fetch_add(1); });
+  jobs.wait(job);
+
+  REQUIRE(sum.load() == 4951);
+}
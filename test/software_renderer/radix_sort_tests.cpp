@@ -0,0 +1,78 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "core/radix_sort.hpp"
+
+namespace {
+
+// Entries with keys drawn from key_range values, so most keys repeat, and indices in input order
+auto make_entries(const std::size_t count, const std::uint32_t key_range, const unsigned seed) -> std::vector<std::uint64_t> {
+  std::mt19937 rng{seed};
+  std::uniform_int_distribution<std::uint32_t> key{0, key_range - 1};
+
+  std::vector<std::uint64_t> entries(count);
+  for (std::size_t i = 0; i < count; i++) {
+    // spread the keys over all four bytes
+    entries[i] = swr::make_sort_entry(key(rng) * 0x01010101u, static_cast<std::uint32_t>(i));
+  }
+  return entries;
+}
+
+// Reference order, by key only, equal keys keep their input order
+auto stable_sorted(std::vector<std::uint64_t> entries) -> std::vector<std::uint64_t> {
+  std::ranges::stable_sort(entries, [](const std::uint64_t lhs, const std::uint64_t rhs) { return (lhs >> 32) < (rhs >> 32); });
+  return entries;
+}
+
+}  // namespace
+
+TEST_CASE("Radix sort is stable", "[RadixSort]") {
+  swr::RadixSorter sorter{};
+
+  for (const std::size_t count : {0, 1, 2, 255, 1000, 20000}) {
+    for (const std::uint32_t key_range : {1u, 7u, 256u, 1u << 24}) {
+      auto entries = make_entries(count, key_range, static_cast<unsigned>(count + key_range));
+      const auto expected = stable_sorted(entries);
+
+      sorter.sort(entries);
+      REQUIRE(entries == expected);
+    }
+  }
+}
+
+TEST_CASE("Parallel and serial radix sort give the same order", "[RadixSort]") {
+  swr::JobSystem jobs{4};
+  swr::RadixSorter serial{};
+  swr::RadixSorter parallel{};
+
+  // above PARALLEL_THRESHOLD and not a multiple of BLOCK_SIZE, so the last block is partial
+  const auto count = swr::RadixSorter::PARALLEL_THRESHOLD * 2 + 12345;
+
+  for (const std::uint32_t key_range : {3u, 1000u, 1u << 30}) {
+    const auto entries = make_entries(count, key_range, key_range);
+    const auto expected = stable_sorted(entries);
+
+    auto serial_entries = entries;
+    serial.sort(serial_entries);
+    auto parallel_entries = entries;
+    parallel.sort(parallel_entries, &jobs);
+
+    REQUIRE(serial_entries == expected);
+    REQUIRE(parallel_entries == expected);
+  }
+}
+
+TEST_CASE("Sortable keys order like the floats they come from", "[RadixSort]") {
+  const std::vector<float> values{-1e30f, -2.5f, -1.0f, -0.0f, 0.0f, 1e-30f, 0.5f, 1.0f, 3.0f, 1e30f};
+
+  for (std::size_t i = 1; i < values.size(); i++) {
+    REQUIRE(swr::sortable_key(values[i - 1]) <= swr::sortable_key(values[i]));
+  }
+  REQUIRE(swr::sortable_key(-2.5f) < swr::sortable_key(-1.0f));
+  REQUIRE(swr::sortable_key(0.5f) < swr::sortable_key(1.0f));
+}
@@ -0,0 +1,212 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "core/canvas.hpp"
+
+namespace {
+
+constexpr int WIDTH = 300;
+constexpr int HEIGHT = 200;
+constexpr int TILE_SIZE = 64;
+
+// Pipeline counting how many times every pixel is written
+struct CountingPipeline {
+  std::vector<int>* hits;
+
+  auto shade_span(const swr::SpanTarget& target, const int x0, const int x1) const -> std::size_t {
+    for (int x = x0; x < x1; x++) {
+      (*hits)[static_cast<std::size_t>(target.y) * WIDTH + x]++;
+    }
+    return static_cast<std::size_t>(x1 - x0);
+  }
+};
+
+struct Mesh {
+  std::vector<swr::Vertex2> vertices;
+  std::vector<std::size_t> indices;
+};
+
+/**
+ * Grid of quads covering the whole canvas, split into triangles along alternating diagonals. Inner vertices are
+ * moved by up to jitter pixels and snapped to multiples of snap pixels, border vertices only move along the border.
+ * Cells are about 12 pixels wide, a jitter below a fifth of that keeps every quad convex, so no triangles overlap.
+ */
+auto make_grid(const float jitter, const float snap, const unsigned seed) -> Mesh {
+  constexpr int COLUMNS = 23;
+  constexpr int ROWS = 17;
+
+  std::mt19937 rng{seed};
+  std::uniform_real_distribution<float> offset{-jitter, jitter};
+  const auto snapped = [snap](const float value) { return snap > 0.0f ? std::round(value / snap) * snap : value; };
+
+  Mesh mesh{};
+  for (int j = 0; j <= ROWS; j++) {
+    for (int i = 0; i <= COLUMNS; i++) {
+      auto x = static_cast<float>(WIDTH * i) / COLUMNS;
+      auto y = static_cast<float>(HEIGHT * j) / ROWS;
+      if (i > 0 && i < COLUMNS) {
+        x = snapped(x + offset(rng));
+      }
+      if (j > 0 && j < ROWS) {
+        y = snapped(y + offset(rng));
+      }
+      mesh.vertices.emplace_back(x, y);
+    }
+  }
+
+  for (int j = 0; j < ROWS; j++) {
+    for (int i = 0; i < COLUMNS; i++) {
+      const auto a = static_cast<std::size_t>(j * (COLUMNS + 1) + i);
+      const auto b = a + 1;
+      const auto c = a + COLUMNS + 1;
+      const auto d = c + 1;
+      // both windings and both diagonals
+      if ((i + j) % 2 == 0) {
+        mesh.indices.insert(mesh.indices.end(), {a, b, d, a, d, c});
+      } else {
+        mesh.indices.insert(mesh.indices.end(), {a, c, b, b, c, d});
+      }
+    }
+  }
+
+  return mesh;
+}
+
+auto rasterize(const Mesh& mesh, const bool per_tile) -> std::vector<int> {
+  swr::Canvas canvas{WIDTH, HEIGHT};
+  std::vector<int> hits(static_cast<std::size_t>(WIDTH) * HEIGHT, 0);
+  const CountingPipeline pipeline{&hits};
+
+  for (std::size_t i = 0; i < mesh.indices.size(); i += 3) {
+    const auto& v0 = mesh.vertices[mesh.indices[i]];
+    const auto& v1 = mesh.vertices[mesh.indices[i + 1]];
+    const auto& v2 = mesh.vertices[mesh.indices[i + 2]];
+
+    if (!per_tile) {
+      canvas.rasterize_triangle(v0, v1, v2, pipeline, canvas.bounds());
+      continue;
+    }
+
+    for (int y = 0; y < HEIGHT; y += TILE_SIZE) {
+      for (int x = 0; x < WIDTH; x += TILE_SIZE) {
+        canvas.rasterize_triangle(v0, v1, v2, pipeline, swr::Rect{x, y, std::min(x + TILE_SIZE, WIDTH), std::min(y + TILE_SIZE, HEIGHT)});
+      }
+    }
+  }
+
+  return hits;
+}
+
+auto hit_exactly_once(const std::vector<int>& hits) -> bool {
+  return std::ranges::all_of(hits, [](const int count) { return count == 1; });
+}
+
+}  // namespace
+
+TEST_CASE("Shared edges cover every pixel exactly once", "[Rasterizer]") {
+  for (unsigned seed = 0; seed < 8; seed++) {
+    // free positions, and positions on the half pixel grid that put many pixel centers exactly on edges
+    for (const auto snap : {0.0f, 0.5f}) {
+      const auto mesh = make_grid(2.0f, snap, seed);
+
+      REQUIRE(hit_exactly_once(rasterize(mesh, false)));
+      REQUIRE(hit_exactly_once(rasterize(mesh, true)));
+    }
+  }
+}
+
+TEST_CASE("Tiles cover the same pixels as the whole triangle", "[Rasterizer]") {
+  const auto mesh = make_grid(2.0f, 1.0f / swr::SUBPIXEL_SCALE, 42);
+
+  REQUIRE(rasterize(mesh, false) == rasterize(mesh, true));
+}
+
+TEST_CASE("Id masked outlines skip pixels of later primitives only", "[Rasterizer]") {
+  swr::Canvas masked{WIDTH, HEIGHT};
+  swr::Canvas plain{WIDTH, HEIGHT};
+  masked.clear_color(0);
+  plain.clear_color(0);
+
+  // ids 1 and 3 cover two overlapping triangles, the outlines are drawn as primitive 2
+  const auto bounds = masked.bounds();
+  masked.draw_triangle_id(swr::Vertex2{10.0f, 10.0f}, swr::Vertex2{200.0f, 30.0f}, swr::Vertex2{40.0f, 150.0f}, 1, bounds);
+  masked.draw_triangle_id(swr::Vertex2{120.0f, 20.0f}, swr::Vertex2{290.0f, 190.0f}, swr::Vertex2{60.0f, 180.0f}, 3, bounds);
+
+  const auto draw = [](swr::Canvas& canvas, const auto& mask) {
+    const auto clip = canvas.bounds();
+    canvas.draw_triangle(5, 5, 295, 100, 150, 195, 0xFFFFFFFF, clip, mask);
+    canvas.draw_line(0, 90, WIDTH - 1, 90, 0xFFFFFFFF, clip, mask);
+    canvas.draw_line(130, 0, 130, HEIGHT - 1, 0xFFFFFFFF, clip, mask);
+    canvas.draw_rectangle(100, 100, 40, 30, 0xFFFF0000, clip, mask);
+  };
+  draw(masked, masked.id_mask(2));
+  draw(plain, swr::Canvas::Unmasked{});
+
+  const auto& ids = masked.get_id_buffer();
+  const auto& expected = plain.get_color_buffer();
+  const auto& actual = masked.get_color_buffer();
+  std::size_t hidden = 0;
+  for (std::size_t i = 0; i < ids.size(); i++) {
+    if (ids[i] == 3 && expected[i] != 0) {
+      REQUIRE(actual[i] == 0);
+      hidden++;
+    } else {
+      REQUIRE(actual[i] == expected[i]);
+    }
+  }
+  REQUIRE(hidden > 0);
+}
+
+TEST_CASE("Depth prepass shades every pixel of the nearest surface once", "[Rasterizer]") {
+  struct Surface {
+    swr::Vertex2 vertices[3];
+    swr::AttributePlane depth;
+    std::uint32_t color;
+  };
+
+  // overlapping triangles at depths far enough apart that their tilted planes never cross, in no particular order
+  std::mt19937 rng{7};
+  std::uniform_real_distribution<float> x{-50.0f, WIDTH + 50.0f};
+  std::uniform_real_distribution<float> y{-50.0f, HEIGHT + 50.0f};
+  std::vector<Surface> surfaces;
+  for (int i = 0; i < 24; i++) {
+    const auto base = 0.1f + 0.03f * static_cast<float>((i * 7) % 24);
+    surfaces.push_back(Surface{{swr::Vertex2{x(rng), y(rng)}, swr::Vertex2{x(rng), y(rng)}, swr::Vertex2{x(rng), y(rng)}},
+                               swr::AttributePlane{1e-5f, -2e-5f, base},
+                               0xFF000000u | static_cast<std::uint32_t>(i + 1)});
+  }
+
+  // depth tested colors in one pass as the reference
+  swr::Canvas expected{WIDTH, HEIGHT};
+  expected.clear_color(0);
+  expected.clear_depth(expected.bounds());
+  for (const auto& [vertices, depth, color] : surfaces) {
+    expected.draw_filled_triangle_depth(vertices[0], vertices[1], vertices[2], depth, color, expected.bounds());
+  }
+
+  swr::Canvas canvas{WIDTH, HEIGHT};
+  canvas.clear_color(0);
+  canvas.clear_depth(canvas.bounds());
+  for (const auto& [vertices, depth, color] : surfaces) {
+    canvas.draw_triangle_depth(vertices[0], vertices[1], vertices[2], depth, canvas.bounds());
+  }
+  REQUIRE(std::ranges::all_of(canvas.get_color_buffer(), [](const std::uint32_t color) { return color == 0; }));
+  REQUIRE(canvas.get_z_buffer() == expected.get_z_buffer());
+
+  std::size_t shaded = 0;
+  for (const auto& [vertices, depth, color] : surfaces) {
+    const swr::PixelPipeline<swr::FlatShader, swr::DepthEqual> pipeline{swr::FlatShader{color}, swr::DepthEqual{depth}};
+    shaded += canvas.rasterize_triangle(vertices[0], vertices[1], vertices[2], pipeline, canvas.bounds());
+  }
+
+  const auto covered = std::ranges::count_if(expected.get_color_buffer(), [](const std::uint32_t color) { return color != 0; });
+  REQUIRE(covered > 0);
+  REQUIRE(canvas.get_color_buffer() == expected.get_color_buffer());
+  REQUIRE(shaded == static_cast<std::size_t>(covered));
+}
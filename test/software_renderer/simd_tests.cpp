@@ -0,0 +1,154 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "core/simd.hpp"
+
+namespace simd = swr::simd;
+
+namespace {
+
+// lengths up to here cover every tail length of the widest registers a few times over
+constexpr std::size_t MAX_LENGTH = 67;
+
+auto make_colors(const std::size_t count, const unsigned seed) -> std::vector<std::uint32_t> {
+  std::mt19937 rng{seed};
+  std::vector<std::uint32_t> colors(count);
+  for (auto& color : colors) {
+    color = rng();
+  }
+  // channels at both ends of the range
+  if (count >= 2) {
+    colors[0] = 0x00000000;
+    colors[1] = 0xFFFFFFFF;
+  }
+  return colors;
+}
+
+const std::uint32_t FACTORS[] = {0x00000000, 0xFFFFFFFF, 0xFF808080, 0x01FE7F80, 0x12345678};
+const std::uint8_t WEIGHTS[] = {0, 1, 127, 128, 254, 255};
+
+/**
+ * Runs kernel(colors, count) -> processed over every length, the processed colors must equal scalar(color) and
+ * the rest must be left alone. A kernel of the public API processes all of them.
+ */
+template <typename Kernel, typename Scalar>
+void check_kernel(const std::size_t width, Kernel&& kernel, Scalar&& scalar) {
+  for (std::size_t count = 0; count <= MAX_LENGTH; count++) {
+    const auto input = make_colors(count, static_cast<unsigned>(count));
+    auto colors = input;
+
+    const std::size_t processed = kernel(colors.data(), count);
+    REQUIRE(processed == count - count % width);
+
+    for (std::size_t i = 0; i < count; i++) {
+      REQUIRE(colors[i] == (i < processed ? scalar(input[i]) : input[i]));
+    }
+  }
+}
+
+// Checks the kernels of one instruction set against the scalar reference functions
+template <typename Isa>
+void check_isa() {
+  for (const auto factor : FACTORS) {
+    check_kernel(
+        Isa::WIDTH, [&](std::uint32_t* c, const std::size_t n) { return simd::detail::modulate_colors<Isa>(c, n, factor); },
+        [&](const std::uint32_t c) { return simd::modulate_color(c, factor); });
+    check_kernel(
+        Isa::WIDTH, [&](std::uint32_t* c, const std::size_t n) { return simd::detail::add_colors<Isa>(c, n, factor); },
+        [&](const std::uint32_t c) { return simd::add_color(c, factor); });
+
+    for (const auto t : WEIGHTS) {
+      check_kernel(
+          Isa::WIDTH, [&](std::uint32_t* c, const std::size_t n) { return simd::detail::lerp_colors<Isa>(c, n, factor, t); },
+          [&](const std::uint32_t c) { return simd::lerp_color(c, factor, t); });
+    }
+  }
+}
+
+}  // namespace
+
+TEST_CASE("Scalar color functions keep the range ends", "[Simd]") {
+  REQUIRE(simd::modulate_color(0xFFFFFFFF, 0xFFFFFFFF) == 0xFFFFFFFF);
+  REQUIRE(simd::modulate_color(0x12345678, 0xFFFFFFFF) == 0x12345678);
+  REQUIRE(simd::modulate_color(0x12345678, 0x00000000) == 0x00000000);
+  REQUIRE(simd::add_color(0x80FF0010, 0x80010020) == 0xFFFF0030);
+  REQUIRE(simd::lerp_color(0x12345678, 0xFFFFFFFF, 0) == 0x12345678);
+  REQUIRE(simd::lerp_color(0x12345678, 0xABCDEF01, 255) == 0xABCDEF01);
+}
+
+#if SWR_HAS_SSE2
+TEST_CASE("SSE2 color kernels match the scalar functions", "[Simd]") {
+  check_isa<simd::detail::Sse2>();
+}
+#endif
+
+#if SWR_HAS_AVX2
+TEST_CASE("AVX2 color kernels match the scalar functions", "[Simd]") {
+  check_isa<simd::detail::Avx2>();
+}
+#endif
+
+#if SWR_HAS_AVX512BW
+TEST_CASE("AVX-512 color kernels match the scalar functions", "[Simd]") {
+  check_isa<simd::detail::Avx512>();
+}
+#endif
+
+TEST_CASE("Color span functions match the scalar functions", "[Simd]") {
+  for (const auto factor : FACTORS) {
+    check_kernel(
+        1, [&](std::uint32_t* c, const std::size_t n) { simd::modulate_colors(c, n, factor); return n; },
+        [&](const std::uint32_t c) { return simd::modulate_color(c, factor); });
+    check_kernel(
+        1, [&](std::uint32_t* c, const std::size_t n) { simd::add_colors(c, n, factor); return n; },
+        [&](const std::uint32_t c) { return simd::add_color(c, factor); });
+
+    for (const auto t : WEIGHTS) {
+      check_kernel(
+          1, [&](std::uint32_t* c, const std::size_t n) { simd::lerp_colors(c, n, factor, t); return n; },
+          [&](const std::uint32_t c) { return simd::lerp_color(c, factor, t); });
+    }
+  }
+}
+
+TEST_CASE("Depth tested spans keep the nearest depth", "[Simd]") {
+  // depths with a short mantissa are computed exactly, by the vector path and the scalar tail alike
+  constexpr float Z0 = 0.25f;
+  constexpr float DZ = 1.0f / 128.0f;
+
+  for (int count = 0; count <= static_cast<int>(MAX_LENGTH); count++) {
+    for (const int first : {0, 3, 17}) {
+      std::mt19937 rng{static_cast<unsigned>(count * 31 + first)};
+      std::uniform_real_distribution<float> stored{0.0f, 1.0f};
+
+      std::vector<float> input(static_cast<std::size_t>(count));
+      for (auto& depth : input) {
+        depth = stored(rng);
+      }
+      const auto colors = make_colors(static_cast<std::size_t>(count), static_cast<unsigned>(count));
+
+      auto depths = input;
+      auto filled = colors;
+      const auto written = simd::fill_depth_tested(filled.data(), depths.data(), count, first, Z0, DZ, 0xFF00FF00);
+
+      auto depth_only = input;
+      simd::write_depth_tested(depth_only.data(), count, first, Z0, DZ);
+
+      std::size_t expected_written = 0;
+      for (std::size_t i = 0; i < input.size(); i++) {
+        const auto z = static_cast<float>(first + static_cast<int>(i)) * DZ + Z0;
+        const bool passes = z < input[i];
+        expected_written += passes ? 1 : 0;
+
+        REQUIRE(depths[i] == (passes ? z : input[i]));
+        REQUIRE(filled[i] == (passes ? 0xFF00FF00 : colors[i]));
+        REQUIRE(depth_only[i] == depths[i]);
+      }
+      REQUIRE(written == expected_written);
+    }
+  }
+}
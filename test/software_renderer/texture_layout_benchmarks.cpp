@@ -0,0 +1,97 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <numbers>
+#include <string>
+
+#include "core/texture.hpp"
+#include "core/utils.hpp"
+
+#include <internal_use_only/swr_config.hpp>
+
+namespace {
+
+auto make_texture(const std::uint32_t size, const swr::TextureLayout layout) -> swr::Texture {
+  swr::Texture t{};
+  t.width = size;
+  t.height = size;
+  t.texels.resize(static_cast<std::size_t>(size) * size);
+
+  for (std::uint32_t y = 0; y < size; y++) {
+    for (std::uint32_t x = 0; x < size; x++) {
+      t.texels[size * y + x] = 0xFF000000 | (x * 2654435761u ^ y * 40503u);
+    }
+  }
+
+  swr::swizzle_texture(t, layout);
+  return t;
+}
+
+/**
+ * Walks a screen sized grid of pixels whose texture coordinates are rotated by angle around the texture center,
+ * one texel per pixel. That is the access pattern the textured rasterizer has for a rotated textured quad.
+ */
+template <swr::TextureLayout Layout>
+auto sample_rotated(const swr::Texture& texture, const float angle) -> std::uint32_t {
+  constexpr int SCREEN_SIZE = 1024;
+
+  const auto cos_a = std::cos(angle);
+  const auto sin_a = std::sin(angle);
+  const auto half = static_cast<float>(SCREEN_SIZE) / 2.0f;
+
+  std::uint32_t sum = 0;
+  for (int py = 0; py < SCREEN_SIZE; py++) {
+    for (int px = 0; px < SCREEN_SIZE; px++) {
+      const auto sx = static_cast<float>(px) - half;
+      const auto sy = static_cast<float>(py) - half;
+      const auto u = static_cast<int>((sx * cos_a - sy * sin_a) + static_cast<float>(texture.width) / 2.0f);
+      const auto v = static_cast<int>((sx * sin_a + sy * cos_a) + static_cast<float>(texture.height) / 2.0f);
+
+      const auto tex_x = static_cast<std::uint32_t>(u) & (texture.width - 1);
+      const auto tex_y = static_cast<std::uint32_t>(v) & (texture.height - 1);
+      sum += texture.texels[swr::texel_index<Layout>(texture, tex_x, tex_y)];
+    }
+  }
+  return sum;
+}
+
+// the layout is picked once per walk, like the samplers do per triangle
+auto sample_rotated(const swr::Texture& texture, const float angle) -> std::uint32_t {
+  if (texture.layout == swr::TextureLayout::Morton) {
+    return sample_rotated<swr::TextureLayout::Morton>(texture, angle);
+  }
+  return sample_rotated<swr::TextureLayout::Linear>(texture, angle);
+}
+
+void benchmark_layouts(const std::string& name, const swr::Texture& linear, const swr::Texture& tiled) {
+  for (const auto degrees : {0, 30, 45, 60, 90}) {
+    const auto angle = static_cast<float>(degrees) * std::numbers::pi_v<float> / 180.0f;
+
+    // both layouts have to return the same texels
+    REQUIRE(sample_rotated(linear, angle) == sample_rotated(tiled, angle));
+
+    BENCHMARK(name + " linear " + std::to_string(degrees) + " deg") { return sample_rotated(linear, angle); };
+    BENCHMARK(name + " morton " + std::to_string(degrees) + " deg") { return sample_rotated(tiled, angle); };
+  }
+}
+
+}  // namespace
+
+TEST_CASE("Linear vs morton texture sampling", "[!benchmark][Texture]") {
+  const std::string f117_file = std::string(swr::CONTENT_BASE_PATH) + "/f117.png";
+  const auto f117_linear = swr::load_texture(f117_file);
+  const auto f117_morton = swr::load_texture(f117_file, swr::TextureOptions{.layout = swr::TextureLayout::Morton});
+
+  if (f117_morton.layout == swr::TextureLayout::Morton) {
+    benchmark_layouts("f117", f117_linear, f117_morton);
+  } else {
+    WARN("f117.png is missing or not power of two, skipping it");
+  }
+
+  for (const auto size : {1024u, 2048u, 4096u}) {
+    benchmark_layouts(std::to_string(size), make_texture(size, swr::TextureLayout::Linear),
+                      make_texture(size, swr::TextureLayout::Morton));
+  }
+}
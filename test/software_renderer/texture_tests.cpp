@@ -0,0 +1,53 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "core/texture.hpp"
+
+TEST_CASE("Morton index covers every texel once", "[Texture]") {
+  for (const auto& [width, height] : {std::pair{8u, 8u}, std::pair{16u, 4u}, std::pair{2u, 32u}}) {
+    std::vector<int> hits(width * height, 0);
+    for (std::uint32_t y = 0; y < height; y++) {
+      for (std::uint32_t x = 0; x < width; x++) {
+        hits[swr::morton_index(x, y, width, height)]++;
+      }
+    }
+
+    for (const auto hit : hits) {
+      REQUIRE(hit == 1);
+    }
+  }
+}
+
+TEST_CASE("Samplers return the same texels for both layouts", "[Texture]") {
+  swr::Texture linear{};
+  linear.width = 32;
+  linear.height = 16;
+  linear.power_of_two = true;
+  for (std::uint32_t i = 0; i < linear.width * linear.height; i++) {
+    linear.texels.push_back(0xFF000000 | (i * 2654435761u >> 8));
+  }
+
+  auto morton = linear;
+  swr::swizzle_texture(morton, swr::TextureLayout::Morton);
+  REQUIRE(morton.layout == swr::TextureLayout::Morton);
+
+  for (const auto filter : {swr::TextureFilter::Nearest, swr::TextureFilter::Bilinear}) {
+    for (const auto wrap : {swr::TextureWrap::Repeat, swr::TextureWrap::Clamp, swr::TextureWrap::Mirror}) {
+      const swr::SamplerState state{wrap, filter};
+
+      // coordinates outside of [0, 1] exercise the wrap modes
+      for (float v = -1.1f; v < 2.0f; v += 0.037f) {
+        for (float u = -1.3f; u < 2.0f; u += 0.041f) {
+          std::uint32_t expected = 0;
+          std::uint32_t actual = 0;
+          swr::with_sampler(linear, state, [&](const auto& sample) { expected = sample(u, v); });
+          swr::with_sampler(morton, state, [&](const auto& sample) { actual = sample(u, v); });
+          REQUIRE(actual == expected);
+        }
+      }
+    }
+  }
+}